@@ -0,0 +1,264 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Allocations.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <iostream>
+#include <new>
+
+#ifdef _WINDOWS
+#include <malloc.h>
+#endif
+
+struct ZoneAllocations
+{
+    const char *zone;       // Null for allocations made outside every zone
+    int64_t count, bytes;
+    int64_t frame_count, frame_bytes;
+};
+
+// One per thread that has allocated, made with malloc and never freed, so a report can read threads that
+// are gone. Only the owning thread writes; a report taken while others are running is approximate.
+struct ThreadAllocations
+{
+    ZoneAllocations zones[ALLOC_ZONES_PER_THREAD];
+    int zone_count;
+    int64_t frame_count;
+    int warmup_frames;
+    AllocationFold *slice_fold;     // Set while running a slice of another thread's parallel_for
+};
+
+static ThreadAllocations *threads[ALLOC_MAX_THREADS];
+static std::atomic<int> thread_count(0);
+
+static thread_local ThreadAllocations *thread_allocations = nullptr;
+
+static ThreadAllocations *this_thread()
+{
+    if (thread_allocations == nullptr)
+    {
+        // calloc, not new: anything that went through operator new here would come straight back to us
+        thread_allocations = (ThreadAllocations*) calloc(1, sizeof(ThreadAllocations));
+
+        // A thread's first frames set it up: its profiler ring, its thread_locals and so on
+        thread_allocations->warmup_frames = ALLOC_WARMUP_FRAMES;
+
+        int index = thread_count.fetch_add(1);
+        if (index < ALLOC_MAX_THREADS) threads[index] = thread_allocations;
+    }
+
+    return thread_allocations;
+}
+
+// Zone names are string literals, so the pointer is enough to tell them apart
+static ZoneAllocations *zone_allocations(ThreadAllocations *thread, const char *zone)
+{
+    for (int i = 0; i < thread->zone_count; i++)
+    {
+        if (thread->zones[i].zone == zone) return &thread->zones[i];
+    }
+
+    // Out of room: whatever comes next is charged to the last zone, which is wrong but still counted
+    if (thread->zone_count == ALLOC_ZONES_PER_THREAD) return &thread->zones[ALLOC_ZONES_PER_THREAD - 1];
+
+    ZoneAllocations *allocations = &thread->zones[thread->zone_count++];
+    allocations->zone = zone;
+    return allocations;
+}
+
+void Allocations::end_frame()
+{
+    ThreadAllocations *thread = this_thread();
+    int64_t frame_count = thread->frame_count;
+    bool warming_up = thread->warmup_frames > 0;
+
+    // A slice with frames of its own (a whole headless game, say) answers for them itself
+    thread->slice_fold = nullptr;
+
+    thread->frame_count = 0;
+    if (warming_up) thread->warmup_frames--;
+
+    if (!warming_up && frame_count > ALLOC_FRAME_BUDGET)
+    {
+        LOG("A steady-state frame made " << frame_count << " allocations, over the budget of " << ALLOC_FRAME_BUDGET << ":");
+
+        for (int i = 0; i < thread->zone_count; i++)
+        {
+            const ZoneAllocations &zone = thread->zones[i];
+            if (zone.frame_count == 0) continue;
+
+            LOG("    " << (zone.zone != nullptr ? zone.zone : "(no zone)") << ": " << zone.frame_count << " allocations, " << zone.frame_bytes << " bytes");
+        }
+
+        std::cout.flush();
+        assert(false);
+    }
+
+    for (int i = 0; i < thread->zone_count; i++)
+    {
+        thread->zones[i].frame_count = 0;
+        thread->zones[i].frame_bytes = 0;
+    }
+}
+
+AllocationFold *Allocations::begin_slice(AllocationFold *fold)
+{
+    ThreadAllocations *thread = this_thread();
+    AllocationFold *previous = thread->slice_fold;
+    thread->slice_fold = fold;
+
+    return previous;
+}
+
+void Allocations::end_slice(AllocationFold *previous)
+{
+    this_thread()->slice_fold = previous;
+}
+
+void Allocations::add_fold(AllocationFold *fold)
+{
+    int64_t count = fold->count.load();
+    int64_t bytes = fold->bytes.load();
+    if (count == 0) return;
+
+    // Slices of a slice belong to whoever this one is running for
+    ThreadAllocations *thread = this_thread();
+    if (thread->slice_fold != nullptr)
+    {
+        thread->slice_fold->count += count;
+        thread->slice_fold->bytes += bytes;
+        return;
+    }
+
+    // Their own zones already counted them in the run's totals; only the frame is still owed
+    ZoneAllocations *zone = zone_allocations(thread, Profiler::current_zone());
+    zone->frame_count += count;
+    zone->frame_bytes += bytes;
+    thread->frame_count += count;
+}
+
+void Allocations::warm_up()
+{
+    this_thread()->warmup_frames = ALLOC_WARMUP_FRAMES;
+}
+
+void Allocations::report()
+{
+    ZoneAllocations totals[ALLOC_ZONES_PER_THREAD];
+    int total_count = 0;
+
+    // The same zone on different threads is one line
+    int count = thread_count.load() < ALLOC_MAX_THREADS ? thread_count.load() : ALLOC_MAX_THREADS;
+    for (int t = 0; t < count; t++)
+    {
+        const ThreadAllocations *thread = threads[t];
+
+        for (int i = 0; i < thread->zone_count; i++)
+        {
+            const ZoneAllocations &zone = thread->zones[i];
+
+            int j = 0;
+            while (j < total_count && !(totals[j].zone == zone.zone ||
+                   (totals[j].zone != nullptr && zone.zone != nullptr && strcmp(totals[j].zone, zone.zone) == 0))) j++;
+
+            if (j == total_count)
+            {
+                if (total_count == ALLOC_ZONES_PER_THREAD) continue;
+                totals[total_count++] = zone;
+                continue;
+            }
+
+            totals[j].count += zone.count;
+            totals[j].bytes += zone.bytes;
+        }
+    }
+
+    LOG("allocations by zone:");
+    for (int i = 0; i < total_count; i++)
+    {
+        LOG("    " << (totals[i].zone != nullptr ? totals[i].zone : "(no zone)") << ": " << totals[i].count << " allocations, " << totals[i].bytes << " bytes");
+    }
+}
+
+#ifdef ALLOC_TRACKING_ENABLED
+
+static void track(size_t size)
+{
+    ThreadAllocations *thread = this_thread();
+    ZoneAllocations *zone = zone_allocations(thread, Profiler::current_zone());
+
+    zone->count++;
+    zone->bytes += size;
+
+    if (thread->slice_fold != nullptr)
+    {
+        thread->slice_fold->count++;
+        thread->slice_fold->bytes += size;
+    }
+    else
+    {
+        zone->frame_count++;
+        zone->frame_bytes += size;
+        thread->frame_count++;
+    }
+
+    COUNTER_ADD(COUNTER_ALLOCATIONS, 1);
+    COUNTER_ADD(COUNTER_ALLOCATED_BYTES, (int) size);
+}
+
+static void *allocate(size_t size)
+{
+    track(size);
+
+    void *pointer = malloc(size != 0 ? size : 1);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+static void *allocate_aligned(size_t size, std::align_val_t alignment)
+{
+    track(size);
+
+    // aligned_alloc wants a whole number of alignments
+    size_t align = (size_t) alignment;
+    size_t rounded = (size + align - 1) / align * align;
+
+#ifdef _WINDOWS
+    void *pointer = _aligned_malloc(rounded != 0 ? rounded : align, align);
+#else
+    void *pointer = aligned_alloc(align, rounded != 0 ? rounded : align);
+#endif
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+static void free_aligned(void *pointer)
+{
+#ifdef _WINDOWS
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void *operator new(size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+void *operator new[](size_t size, const std::nothrow_t&) noexcept { try { return allocate(size); } catch (...) { return nullptr; } }
+void *operator new(size_t size, std::align_val_t alignment) { return allocate_aligned(size, alignment); }
+void *operator new[](size_t size, std::align_val_t alignment) { return allocate_aligned(size, alignment); }
+
+void operator delete(void *pointer) noexcept { free(pointer); }
+void operator delete[](void *pointer) noexcept { free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t&) noexcept { free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t&) noexcept { free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { free_aligned(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { free_aligned(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { free_aligned(pointer); }
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { free_aligned(pointer); }
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "Counters.h"
+
+// Off unless ALLOC_TRACKING_ENABLED is defined by hand: it replaces the global operator new and delete,
+// which costs a few instructions on every allocation in the program.
+//
+// Every allocation is counted against the thread that made it and the profiler zone it was made in.
+// A thread that calls end_frame() is held to ALLOC_FRAME_BUDGET allocations per frame once it is past
+// its warm-up, and debug builds assert when it goes over, naming the zones that allocated. Slices of a
+// parallel_for that run on other threads are charged to the frame of the thread that called it.
+
+// Allocations a steady-state frame may make
+#define ALLOC_FRAME_BUDGET 0
+
+// Frames after warm_up() that may allocate freely: loading a scene, say, or opening a region
+#define ALLOC_WARMUP_FRAMES 120
+
+// Distinct zones remembered per thread, and threads remembered in all
+#define ALLOC_ZONES_PER_THREAD 128
+#define ALLOC_MAX_THREADS 64
+
+// What the slices of one parallel_for allocated on threads other than the one that called it
+struct AllocationFold
+{
+    std::atomic<int64_t> count, bytes;
+};
+
+class Allocations {
+public:
+    // Checks the frame this thread just finished against the budget and starts counting the next
+    static void end_frame();
+
+    // While this thread runs a slice of someone else's parallel_for, its allocations go to the fold instead of
+    // its own frame, until the slice ends or ends a frame of its own. Returns the fold to hand end_slice().
+    static AllocationFold *begin_slice(AllocationFold *fold);
+    static void end_slice(AllocationFold *previous);
+
+    // Charges what a parallel_for's slices allocated elsewhere to this thread's frame, in the zone it was called from
+    static void add_fold(AllocationFold *fold);
+
+    // Lets this thread's next ALLOC_WARMUP_FRAMES frames allocate as much as they like
+    static void warm_up();
+
+    // Allocations and bytes over the whole run, per zone, every thread's together
+    static void report();
+};
+
+#ifdef ALLOC_TRACKING_ENABLED
+#define ALLOC_FRAME_END() Allocations::end_frame()
+#define ALLOC_WARM_UP()   Allocations::warm_up()
+#else
+#define ALLOC_FRAME_END() ((void) 0)
+#define ALLOC_WARM_UP()   ((void) 0)
+#endif
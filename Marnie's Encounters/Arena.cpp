@@ -0,0 +1,54 @@
+#include "Arena.h"
+#include <stdlib.h>
+
+Arena::~Arena()
+{
+    release();
+    for (size_t i = 0; i < this->blocks.size(); i++) free(this->blocks[i].bytes);
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    // Carry on through the blocks we already have before asking the heap for another
+    for (; this->current < this->blocks.size(); this->current++, this->offset = 0)
+    {
+        const Block &block = this->blocks[this->current];
+
+        size_t start = (this->offset + alignment - 1) & ~(alignment - 1);
+        if (start + size > block.size) continue;
+
+        this->used += start + size - this->offset;
+        this->offset = start + size;
+        return block.bytes + start;
+    }
+
+    // Oversized requests get a block of their own, which is kept like any other
+    Block block;
+    block.size = size + alignment > ARENA_BLOCK_SIZE ? size + alignment : ARENA_BLOCK_SIZE;
+    block.bytes = (unsigned char*) malloc(block.size);
+    this->blocks.push_back(block);
+
+    this->current = this->blocks.size() - 1;
+    this->offset = 0;
+    return allocate(size, alignment);
+}
+
+void Arena::release()
+{
+    for (Finalizer *finalizer = this->finalizers; finalizer != nullptr; finalizer = finalizer->next)
+    {
+        finalizer->destroy(finalizer->objects, finalizer->count);
+    }
+
+    this->finalizers = nullptr;
+    this->current = 0;
+    this->offset = 0;
+    this->used = 0;
+}
+
+size_t const Arena::get_capacity() const
+{
+    size_t capacity = 0;
+    for (size_t i = 0; i < this->blocks.size(); i++) capacity += this->blocks[i].size;
+    return capacity;
+}
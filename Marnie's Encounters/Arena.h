@@ -0,0 +1,101 @@
+#pragma once
+#include <stddef.h>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Big enough for everything any scene makes today, so a scene normally lives in a single block
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+// A bump allocator that owns everything a scene makes between initialise() and unloading. Allocating
+// is moving a pointer along a block. release() runs the destructors that need running, newest first,
+// and rewinds to the start without handing the blocks back, so a scene loaded over and over reuses
+// the same memory and never fragments the heap. Simulation thread only.
+class Arena {
+    struct Block
+    {
+        unsigned char *bytes;
+        size_t size;
+    };
+
+    // Kept inside the arena itself, one per object (or array) whose type has a destructor
+    struct Finalizer
+    {
+        void (*destroy)(void *objects, size_t count);
+        void *objects;
+        size_t count;
+        Finalizer *next;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;     // Block being allocated from
+    size_t offset = 0;      // Within it
+    size_t used = 0;        // Bytes handed out since the last release, padding included
+    Finalizer *finalizers = nullptr;
+
+    template <typename T>
+    static void destroy(void *objects, size_t count)
+    {
+        for (size_t i = count; i-- > 0; ) ((T*) objects)[i].~T();
+    }
+
+    template <typename T>
+    void add_finalizer(T *objects, size_t count)
+    {
+        if (std::is_trivially_destructible<T>::value) return;
+
+        Finalizer *finalizer = (Finalizer*) allocate(sizeof(Finalizer), alignof(Finalizer));
+        finalizer->destroy = &destroy<T>;
+        finalizer->objects = objects;
+        finalizer->count = count;
+        finalizer->next = this->finalizers;
+        this->finalizers = finalizer;
+    }
+
+public:
+    Arena() {};
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena &operator=(const Arena&) = delete;
+
+    // Raw memory, valid until the next release()
+    void *allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+    template <typename T, typename... Arguments>
+    T *create(Arguments&&... arguments)
+    {
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Arguments>(arguments)...);
+        add_finalizer(object, 1);
+        return object;
+    }
+
+    // count default-constructed Ts
+    template <typename T>
+    T *create_array(int count)
+    {
+        T *objects = (T*) allocate(sizeof(T) * count, alignof(T));
+        for (int i = 0; i < count; i++) new (&objects[i]) T();
+        add_finalizer(objects, count);
+        return objects;
+    }
+
+    // A copy of a short table, e.g. an animation's frame indices
+    template <typename T>
+    T *copy_array(std::initializer_list<T> values)
+    {
+        T *objects = (T*) allocate(sizeof(T) * values.size(), alignof(T));
+        size_t i = 0;
+        for (const T &value : values) new (&objects[i++]) T(value);
+        add_finalizer(objects, values.size());
+        return objects;
+    }
+
+    // Destroys everything made since the last release and starts again from the first block
+    void release();
+
+    size_t const get_used() const { return used; };
+    size_t const get_capacity() const;
+};
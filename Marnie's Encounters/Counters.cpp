@@ -0,0 +1,76 @@
+#include "Counters.h"
+
+static const char* const COUNTER_NAMES[COUNTER_COUNT] =
+{
+    "sim steps",
+    "entities",
+    "collision tests",
+    "is_solid calls",
+    "draw calls",
+    "texture binds",
+    "allocations",
+    "allocated bytes"
+};
+
+#ifdef PROFILER_ENABLED
+thread_local int engine_counters[COUNTER_COUNT];
+#endif
+
+static thread_local int last_frame_counters[COUNTER_COUNT];
+
+void Counters::end_frame()
+{
+#ifdef PROFILER_ENABLED
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        last_frame_counters[i] = engine_counters[i];
+        engine_counters[i] = 0;
+    }
+#endif
+}
+
+void Counters::begin_slice(int *saved)
+{
+#ifdef PROFILER_ENABLED
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        saved[i] = engine_counters[i];
+        engine_counters[i] = 0;
+    }
+#else
+    (void) saved;
+#endif
+}
+
+void Counters::end_slice(const int *saved, CounterFold *fold)
+{
+#ifdef PROFILER_ENABLED
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (engine_counters[i] != 0) fold->totals[i] += engine_counters[i];
+        engine_counters[i] = saved[i];
+    }
+#else
+    (void) saved;
+    (void) fold;
+#endif
+}
+
+void Counters::add_fold(CounterFold *fold)
+{
+#ifdef PROFILER_ENABLED
+    for (int i = 0; i < COUNTER_COUNT; i++) engine_counters[i] += fold->totals[i].load();
+#else
+    (void) fold;
+#endif
+}
+
+int const Counters::get_last_frame(EngineCounter counter)
+{
+    return last_frame_counters[counter];
+}
+
+const char* const Counters::get_name(EngineCounter counter)
+{
+    return COUNTER_NAMES[counter];
+}
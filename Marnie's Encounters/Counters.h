@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include "Profiler.h"
+
+enum EngineCounter
+{
+    COUNTER_SIM_STEPS,
+    COUNTER_ENTITIES,
+    COUNTER_COLLISION_TESTS,
+    COUNTER_IS_SOLID_CALLS,
+    COUNTER_DRAW_CALLS,
+    COUNTER_TEXTURE_BINDS,
+    COUNTER_ALLOCATIONS,        // Only counted with ALLOC_TRACKING_ENABLED
+    COUNTER_ALLOCATED_BYTES,
+    COUNTER_COUNT
+};
+
+// What the slices of one parallel_for counted on threads other than the one that called it
+struct CounterFold
+{
+    std::atomic<int> totals[COUNTER_COUNT];
+};
+
+class Counters {
+public:
+    // Moves this thread's running totals into its "last frame" slots and starts again from zero
+    static void end_frame();
+
+    // A thread running a slice of someone else's parallel_for counts it apart from its own totals and hands
+    // the slice's counts to the fold; the caller adds the fold to its totals once every slice is done, so its
+    // end_frame() sees the work wherever it ran
+    static void begin_slice(int *saved);
+    static void end_slice(const int *saved, CounterFold *fold);
+    static void add_fold(CounterFold *fold);
+
+    static int const get_last_frame(EngineCounter counter);
+    static const char* const get_name(EngineCounter counter);
+};
+
+// Counters live with the profiler: in builds without PROFILER_ENABLED the macros are no-ops.
+// Totals are per thread, so simulations running on other threads never race with the HUD.
+#ifdef PROFILER_ENABLED
+extern thread_local int engine_counters[COUNTER_COUNT];
+
+#define COUNTER_ADD(counter, amount) (engine_counters[counter] += (amount))
+#define COUNTER_SET(counter, value)  (engine_counters[counter] = (value))
+#else
+#define COUNTER_ADD(counter, amount) ((void) 0)
+#define COUNTER_SET(counter, value)  ((void) 0)
+#endif
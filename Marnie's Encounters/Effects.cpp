@@ -1,11 +1,14 @@
 #include "Effects.h"
+#include "Counters.h"
 
-Effects::Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix)
+Effects::Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix, Rng *rng)
 {
+    this->rng = rng;
+    
     // Non textured Shader
-    program.Load("shaders/vertex.glsl", "shaders/fragment.glsl");
-    program.SetProjectionMatrix(projection_matrix);
-    program.SetViewMatrix(view_matrix);
+    program = ShaderProgram::Get(SHADER_VERTEX, SHADER_FRAGMENT);
+    program->SetProjectionMatrix(projection_matrix);
+    program->SetViewMatrix(view_matrix);
     
     this->current_effect = NONE;
     this->alpha = 1.0f;
@@ -17,7 +20,7 @@ Effects::Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix)
 
 void Effects::draw_overlay()
 {
-    glUseProgram(this->program.programID);
+    glUseProgram(this->program->programID);
 
     float vertices[] =
     {
@@ -30,10 +33,11 @@ void Effects::draw_overlay()
         -0.5,  0.5
     };
 
-    glVertexAttribPointer(this->program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(this->program.positionAttribute);
+    glVertexAttribPointer(this->program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
+    glEnableVertexAttribArray(this->program->positionAttribute);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glDisableVertexAttribArray(this->program.positionAttribute);
+    COUNTER_ADD(COUNTER_DRAW_CALLS, 1);
+    glDisableVertexAttribArray(this->program->positionAttribute);
 }
 
 void Effects::start(EffectType effect_type, float effect_speed)
@@ -89,7 +93,7 @@ void Effects::update(float delta_time)
            {
                float min = -0.1f;
                float max =  0.0f;
-               float offset_value = ((float) rand() / RAND_MAX) * (max - min) + min;
+               float offset_value = this->rng->range(min, max);
                this->view_offset = glm::vec3(offset_value, offset_value, 0.0f);
            }
    }
@@ -115,8 +119,8 @@ void Effects::render()
                                                     this->size : this->size * 0.75f,
                                                 0.0f));
             
-            this->program.SetModelMatrix(model_matrix);
-            this->program.SetColor(0.0f, 0.0f, 0.0f, this->alpha);
+            this->program->SetModelMatrix(model_matrix);
+            this->program->SetColor(0.0f, 0.0f, 0.0f, this->alpha);
             this->draw_overlay();
 
             break;
@@ -13,24 +13,28 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "Random.h"
 
 enum EffectType { NONE, FADEIN, FADEOUT, GROW, SHRINK, SHAKE };
 
 class Effects {
-    ShaderProgram program;
+    ShaderProgram *program;     // Owned by the program cache
     float alpha;
     float effect_speed;
     float size;
     float time_left;
     EffectType current_effect;
+    Rng *rng;
 
 public:
     glm::vec3 view_offset;
     
-    Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix);
+    Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix, Rng *rng);
 
     void draw_overlay();
     void start(EffectType effect_type, float effect_speed);
     void update(float delta_time);
     void render();
+
+    bool const is_active() const { return current_effect != NONE; };
 };
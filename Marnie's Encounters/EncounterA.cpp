@@ -1,71 +1,59 @@
 #include "EncounterA.h"
 #include "Utility.h"
+#include "Counters.h"
 #include <cmath>
 
-#define LEVEL_WIDTH 18
-#define LEVEL_HEIGHT 8
 #define PHASE1LENGTH 10.0f
 #define PHASE2LENGTH 10.0f
 #define PHASE3LENGTH 10.0f
 #define PHASE4LENGTH 10.0f
 #define PHASE5LENGTH 20.0f
+#define FIREBALL_LIGHT_RADIUS 2.5f
+#define FIREBALL_LIGHT_INTENSITY 0.6f
 #define LOG(argument) std::cout << argument << '\n'
 
 const int FONTBANK_SIZE = 16;
 
-unsigned int ENCOUNTERA_DATA[] =
+// Every texture the scene draws with, asked for together so they decode in parallel
+const char* const ENCOUNTER_A_TEXTURES[] =
 {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    "assets/tileset.png",
+    "assets/fireball_small.png",
+    "assets/fireball_large.png",
+    "assets/font1.png",
+    "assets/pokeball.png"
 };
+const int ENCOUNTER_A_TEXTURE_COUNT = sizeof(ENCOUNTER_A_TEXTURES) / sizeof(ENCOUNTER_A_TEXTURES[0]);
 
-GLuint map_texture_id;
-GLuint fireball_small_texture_id;
-GLuint fireball_large_texture_id;
-
-float passed_time = 0.0f;
-float prevSpawnTime = 0.0f;
-
-bool win = false;
-
-EncounterA::~EncounterA() {
-    for (size_t i = 0; i < state.vec_enemies.size(); i++) {
-        delete state.vec_enemies.at(i);
-    }
-
-    delete    this->state.player;
-    delete    this->state.map;
-    Mix_FreeChunk(this->state.jump_sfx);
-    Mix_FreeMusic(this->state.bgm);
+void EncounterA::unload() {
+    // The script is suspended partway through this run of the encounter; start the next from the top
+    timeline.clear();
+    Scene::unload();
 }
 
 void EncounterA::initialise() {
-    map_texture_id = Utility::load_texture("assets/tileset.png");
-    fireball_small_texture_id = Utility::load_texture("assets/fireball_small.png");
-    fireball_large_texture_id = Utility::load_texture("assets/fireball_large.png");
+    state.resources->preload_textures(ENCOUNTER_A_TEXTURES, ENCOUNTER_A_TEXTURE_COUNT);
+    map_texture_id = state.resources->texture("assets/tileset.png");
+    fireball_small_texture_id = state.resources->texture("assets/fireball_small.png");
+    fireball_large_texture_id = state.resources->texture("assets/fireball_large.png");
+    font_texture_id = state.resources->texture("assets/font1.png");
 
     state.next_scene_id = -1;
     
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, ENCOUNTERA_DATA, map_texture_id, 1.0f, 4, 1);
+    this->state.map = arena.create<Map>(new Level("levels/encounterA.lvl"), map_texture_id, state.resources);
     
     // Code from main.cpp's initialise()
     /**
      George's Stuff
      */
     // Existing
-    state.player = new Entity();
+    state.player = arena.create<Entity>();
     state.player->set_entity_type(PLAYER);
-    state.player->set_position(glm::vec3(5.0f, -3.5f, 0.0f));
+    state.player->set_position(player_spawn());
     state.player->set_movement(glm::vec3(0.0f));
     state.player->speed = 3.5f;
     state.player->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/pokeball.png");   
+    state.player->texture_id = state.resources->texture("assets/pokeball.png");   
     state.player->height = 0.5f;
     state.player->width = 0.5f;
     
@@ -91,183 +79,120 @@ void EncounterA::initialise() {
     /**
      BGM and SFX
      */
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
     
-    //state.bgm = Mix_LoadMUS("assets/marnie.mp3");
-    //Mix_PlayMusic(state.bgm, -1);
-    Mix_VolumeMusic(30.0f);
+    //state.bgm = state.resources->music("assets/marnie.mp3");
+    //state.resources->play_music(state.bgm);
+    state.resources->set_music_volume(30);
+    
+    state.jump_sfx = state.resources->sound("assets/bounce.wav");
+    state.win_sfx = state.resources->sound("assets/win.wav");
+    state.lose_sfx = state.resources->sound("assets/lose.wav");
+    
+    /**
+     Fireball patterns
+     */
+    projectiles.clear();
+    projectiles.set_bounds(glm::vec2(-3.0f, -14.0f), glm::vec2(13.0f, 4.0f));
+    
+    patterns.reset(&state.random->bulk(RNG_SPAWNER));
     
-    state.jump_sfx = Mix_LoadWAV("assets/bounce.wav");
-    state.win_sfx = Mix_LoadWAV("assets/win.wav");
-    state.lose_sfx = Mix_LoadWAV("assets/lose.wav");
+    win = false;
+    timeline.clear();
+    timeline.start(script());
 }
 
-void EncounterA::update(float delta_time) {
-    passed_time += delta_time;
-
-    // Phase 1
-    if (passed_time > 2.0f && passed_time < PHASE1LENGTH + 2.0f && passed_time - prevSpawnTime > 0.25f) {
-        prevSpawnTime = passed_time;
-        Entity* ball1 = new Entity();
-        ball1->set_entity_type(ENEMY);
-        ball1->set_ai_type(STANDER);
-        ball1->set_ai_state(IDLE);
-        ball1->texture_id = fireball_large_texture_id;
-        ball1->set_position(glm::vec3(Utility::random(1.0f, 9.0f), 1.0f , 0.0f));
-        ball1->set_movement(glm::vec3(0.0f, -1.0f, 0.0f));
-        ball1->speed = 6.0f;
-        ball1->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball1->height = 0.6f;
-        ball1->width = 0.6f;
-        state.vec_enemies.push_back(ball1);
-    }
-
-    if (passed_time > PHASE1LENGTH + 4.0f && passed_time < PHASE1LENGTH + PHASE2LENGTH + 4.0f && passed_time - prevSpawnTime > 0.4f) {
-        prevSpawnTime = passed_time;
-        prevSpawnTime = passed_time;
-        Entity* ball1 = new Entity();
-        ball1->set_entity_type(ENEMY);
-        ball1->set_ai_type(STANDER);
-        ball1->set_ai_state(IDLE);
-        ball1->texture_id = fireball_large_texture_id;
-        ball1->set_position(glm::vec3(-1.0f,
-            state.player->get_position().y, 0.0f));
-        ball1->set_movement(glm::vec3(1.0f, 0.0f, 0.0f));
-        ball1->speed = 2.5f;
-        ball1->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball1->height = 0.6f;
-        ball1->width = 0.6f;
-        state.vec_enemies.push_back(ball1);
-    }
-
-    if (passed_time > PHASE1LENGTH + PHASE2LENGTH + 6.0f && passed_time < 
-        PHASE1LENGTH + PHASE2LENGTH + PHASE3LENGTH + 6.0f && passed_time - prevSpawnTime > 0.5f) {
-        prevSpawnTime = passed_time;
-        Entity* ball1 = new Entity();
-        ball1->set_entity_type(ENEMY);
-        ball1->set_ai_type(STANDER);
-        ball1->set_ai_state(IDLE);
-        ball1->texture_id = fireball_large_texture_id;
-        ball1->set_position(glm::vec3(Utility::random(1.0f, 9.0f), 1.0f, 0.0f));
-        ball1->set_movement(glm::vec3(0.0f, -1.0f, 0.0f));
-        ball1->speed = 3.0f;
-        ball1->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball1->height = 0.5f;
-        ball1->width = 0.5f;
-        state.vec_enemies.push_back(ball1);
-
-        Entity* ball2 = new Entity();
-        ball2->set_entity_type(ENEMY);
-        ball2->set_ai_type(STANDER);
-        ball2->set_ai_state(IDLE);
-        ball2->texture_id = fireball_large_texture_id;
-        ball2->set_position(glm::vec3(Utility::random(1.0f, 9.0f), -11.0f, 0.0f));
-        ball2->set_movement(glm::vec3(0.0f, 1.0f, 0.0f));
-        ball2->speed = 3.0f;
-        ball2->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball2->height = 0.5f;
-        ball2->width = 0.5f;
-        state.vec_enemies.push_back(ball2);
-    }
-
-    if (passed_time > PHASE1LENGTH + PHASE2LENGTH + PHASE3LENGTH + 6.0f && passed_time <
-        PHASE1LENGTH + PHASE2LENGTH + PHASE3LENGTH + PHASE4LENGTH + 6.0f && passed_time - prevSpawnTime > 0.4f) {
-        prevSpawnTime = passed_time;
-        Entity* ball1 = new Entity();
-        ball1->set_entity_type(ENEMY);
-        ball1->set_ai_type(STANDER);
-        ball1->set_ai_state(IDLE);
-        ball1->texture_id = fireball_large_texture_id;
-        ball1->set_position(glm::vec3(0.0f, Utility::random(-10.0f, 0.0f), 0.0f));
-        ball1->set_movement(glm::vec3(1.0f, 0.0f, 0.0f));
-        ball1->speed = 2.5f;
-        ball1->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball1->height = 0.5f;
-        ball1->width = 0.5f;
-        state.vec_enemies.push_back(ball1);
-
-        Entity* ball2 = new Entity();
-        ball2->set_entity_type(ENEMY);
-        ball2->set_ai_type(STANDER);
-        ball2->set_ai_state(IDLE);
-        ball2->texture_id = fireball_large_texture_id;
-        ball2->set_position(glm::vec3(10.0f, Utility::random(-10.0f, 0.0f), 0.0f));
-        ball2->set_movement(glm::vec3(-1.0f, 0.0f, 0.0f));
-        ball2->speed = 3.0f;
-        ball2->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball2->height = 0.5f;
-        ball2->width = 0.5f;
-        state.vec_enemies.push_back(ball2);
-    }
-
-    if (passed_time > PHASE1LENGTH + PHASE2LENGTH + PHASE3LENGTH + PHASE4LENGTH + 6.0f && passed_time <
-        PHASE1LENGTH + PHASE2LENGTH + PHASE3LENGTH + PHASE4LENGTH + PHASE5LENGTH + 6.0f && passed_time - prevSpawnTime > 0.2f) {
-        prevSpawnTime = passed_time;
-        Entity* ball1 = new Entity();
-        ball1->set_entity_type(ENEMY);
-        ball1->set_ai_type(STANDER);
-        ball1->set_ai_state(IDLE);
-        ball1->texture_id = fireball_large_texture_id;
-        
-        glm::vec3 spawnPos = glm::vec3(0.0f, 0.0f, 0.0f);
-
-        if (Utility::random(0, 100) < 50) {
-            spawnPos.x = Utility::random(-1.0f, 11.0f);
-            if (Utility::random(0, 100) < 50) {
-                spawnPos.y = -12.0f;
-            }
-            else {
-                spawnPos.y = 2.0f;
-            }
-        } else{
-            spawnPos.y = Utility::random(-12.0f, 2.0f);
-            if (Utility::random(0, 100) < 50) {
-                spawnPos.x = -1.0f;
-            }
-            else {
-                spawnPos.x = 11.0f;
-            }
-        }
-
-        ball1->set_position(spawnPos);
-        
-        float y_dist = state.player->get_position().y - ball1->get_position().y;
-        float x_dist = state.player->get_position().x - ball1->get_position().x;
-
-        ball1->set_movement(glm::vec3(cos(atan2f(y_dist, x_dist)), sin(atan2f(y_dist, x_dist)), 0.0f));
-        ball1->speed = 3.0f;
-        ball1->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-        ball1->height = 0.4f;
-        ball1->width = 0.4f;
-        state.vec_enemies.push_back(ball1);
-    }
-
-    if (state.player->is_active && passed_time > PHASE1LENGTH + PHASE2LENGTH + PHASE3LENGTH + PHASE4LENGTH + PHASE5LENGTH + 6.0f && !win) {
-        Mix_PlayChannel(-1, state.win_sfx, 0);
-        Mix_HaltMusic();
+ScriptTask EncounterA::script()
+{
+    int fireball = projectiles.add_texture(fireball_large_texture_id);
+    
+    PatternBuilder rain, sweep, pincer, crossfire, hunt;
+    rain.texture(fireball).origin_random_x(1.0f, 9.0f, 1.0f).direction(0.0f, -1.0f).speed(6.0f).size(0.6f).emit();
+    sweep.texture(fireball).origin_player_y(-1.0f).direction(1.0f, 0.0f).speed(2.5f).size(0.6f).emit();
+    pincer.texture(fireball).size(0.5f).speed(3.0f)
+          .origin_random_x(1.0f, 9.0f, 1.0f).direction(0.0f, -1.0f).emit()
+          .origin_random_x(1.0f, 9.0f, -11.0f).direction(0.0f, 1.0f).emit();
+    crossfire.texture(fireball).size(0.5f)
+             .origin_random_y(0.0f, -10.0f, 0.0f).direction(1.0f, 0.0f).speed(2.5f).emit()
+             .origin_random_y(10.0f, -10.0f, 0.0f).direction(-1.0f, 0.0f).speed(3.0f).emit();
+    hunt.texture(fireball).origin_random_edge(-1.0f, 11.0f, -12.0f, 2.0f).aim().speed(3.0f).size(0.4f).emit();
+    
+    co_await seconds(2.0f);
+    
+    // Phase 1: rain from random points along the top
+    timeline.begin_phase(PHASE1LENGTH);
+    patterns.start(patterns.load(rain), 0.25f);
+    co_await phase_end();
+    patterns.stop_all();
+    
+    co_await seconds(2.0f);
+    
+    // Phase 2: slow fireballs from the left, level with the player
+    timeline.begin_phase(PHASE2LENGTH);
+    patterns.start(patterns.load(sweep), 0.4f);
+    co_await phase_end();
+    patterns.stop_all();
+    
+    co_await seconds(2.0f);
+    
+    // Phase 3: from the top and the bottom at once
+    timeline.begin_phase(PHASE3LENGTH);
+    patterns.start(patterns.load(pincer), 0.5f);
+    co_await phase_end();
+    patterns.stop_all();
+    
+    // Phase 4: from both sides at once, straight after
+    timeline.begin_phase(PHASE4LENGTH);
+    patterns.start(patterns.load(crossfire), 0.4f);
+    co_await phase_end();
+    patterns.stop_all();
+    
+    // Phase 5: from anywhere around the arena, aimed at the player
+    timeline.begin_phase(PHASE5LENGTH);
+    patterns.start(patterns.load(hunt), 0.2f);
+    co_await phase_end();
+    patterns.stop_all();
+    
+    if (state.player->is_active) {
+        state.resources->play_sound(state.win_sfx);
+        state.resources->halt_music();
         win = true;
     }
+}
 
-    this->state.player->update(delta_time, state.player, state.vec_enemies, state.vec_enemies.size(), this->state.map);
-    //LOG("Player: " << state.player->get_position().x << " " << state.player->get_position().y);
+void EncounterA::update(float delta_time) {
+    PROFILE_ZONE("EncounterA::update");
+    COUNTER_SET(COUNTER_ENTITIES, live_entity_count());
+    
+    timeline.update(delta_time);
+    patterns.update(delta_time, glm::vec2(state.player->get_position()), &projectiles);
+    projectiles.update(delta_time, state.jobs);
 
-    for (size_t i = 0; i < state.vec_enemies.size(); i++) {
-        auto enemy = state.vec_enemies.at(i);
-        //LOG("Enemy " << i << ": " << enemy->get_position().x << " " << enemy->get_position().y);
-        state.vec_enemies.at(i)->update(delta_time, state.player, state.vec_enemies, state.vec_enemies.size(), this->state.map);
+    this->state.player->update(delta_time, state.player, state.vec_enemies, state.vec_enemies.size(), this->state.map);
+    
+    if (state.player->is_active && projectiles.overlaps(state.player->get_position(), state.player->width, state.player->height)) {
+        state.player->deactivate();
     }
 }
 
-void EncounterA::render(ShaderProgram *program)
+void EncounterA::add_lights(Lighting *lighting)
 {
-    this->state.map->render(program);
-    this->state.player->render(program);
-
-    for (int i = 0; i < state.vec_enemies.size(); i++) {
-        state.vec_enemies.at(i)->render(program);
+    // Every fireball glows; the lighting culls the ones that are off screen
+    for (int i = 0; i < projectiles.size(); i++) {
+        Light glow;
+        glow.position  = projectiles.get_position(i);
+        glow.radius    = FIREBALL_LIGHT_RADIUS;
+        glow.intensity = FIREBALL_LIGHT_INTENSITY;
+        lighting->add_dynamic_light(glow);
     }
+}
+
+void EncounterA::snapshot(RenderSnapshot *snapshot)
+{
+    this->state.map->snapshot(snapshot);
+    this->state.player->snapshot(snapshot);
+    projectiles.snapshot(snapshot);
 
     if (win) {
-        Utility::draw_text(program, Utility::load_texture("assets/font1.png"), "You've won!", 0.5f, 0.001f, glm::vec3(3.0f, -3.0f, 0.0f));
+        snapshot->add_text(font_texture_id, "You've won!", 0.5f, 0.001f, glm::vec3(3.0f, -3.0f, 0.0f));
     }
 }
@@ -1,19 +1,32 @@
 #include "Scene.h"
+#include "Projectiles.h"
+#include "Pattern.h"
+#include "Script.h"
 
 class EncounterA : public Scene {
 public:    
-    ~EncounterA();
-
     bool played = false;
     
     void initialise() override;
+    void unload() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
+    void snapshot(RenderSnapshot *snapshot) override;
+    void add_lights(Lighting *lighting) override;
+    int live_entity_count() const override { return 1 + projectiles.size(); };
+    size_t other_entity_bytes() const override { return projectiles.get_capacity_bytes(); };
 
     GLuint map_texture_id;
+    GLuint font_texture_id;
     GLuint fireball_small_texture_id;
     GLuint fireball_large_texture_id;
 
-    float passed_time = 0.0f;
-    float prevSpawnTime = 0.0f;
+    ProjectileStore projectiles;
+    PatternVM patterns;
+    Timeline timeline;
+
+    bool win = false;
+
+private:
+    // The whole encounter, phase by phase
+    ScriptTask script();
 };
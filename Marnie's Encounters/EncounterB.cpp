@@ -1,57 +1,50 @@
 #include "EncounterB.h"
 #include "Utility.h"
+#include "Counters.h"
 #include <cmath>
 
-#define LEVEL_WIDTH 18
-#define LEVEL_HEIGHT 8
 #define LOG(argument) std::cout << argument << '\n'
 
 const int FONTBANK_SIZE = 16;
 
-unsigned int EncounterB_DATA[] =
+// Every texture the scene draws with, asked for together so they decode in parallel
+const char* const ENCOUNTER_B_TEXTURES[] =
 {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    "assets/tileset.png",
+    "assets/fireball_small.png",
+    "assets/fireball_large.png",
+    "assets/pokeball.png"
 };
+const int ENCOUNTER_B_TEXTURE_COUNT = sizeof(ENCOUNTER_B_TEXTURES) / sizeof(ENCOUNTER_B_TEXTURES[0]);
 
-EncounterB::~EncounterB() {
-    for (size_t i = 0; i < state.vec_enemies.size(); i++) {
-        delete state.vec_enemies.at(i);
-    }
-
-    delete    this->state.player;
-    delete    this->state.map;
-    Mix_FreeChunk(this->state.jump_sfx);
-    Mix_FreeMusic(this->state.bgm);
+void EncounterB::unload() {
+    // The scripts are suspended inside this run of the encounter, holding on to its entities
+    timeline.clear();
+    Scene::unload();
 }
 
 void EncounterB::initialise() {
-    map_texture_id = Utility::load_texture("assets/tileset.png");
-    fireball_small_texture_id = Utility::load_texture("assets/fireball_small.png");
-    fireball_large_texture_id = Utility::load_texture("assets/fireball_large.png");
+    state.resources->preload_textures(ENCOUNTER_B_TEXTURES, ENCOUNTER_B_TEXTURE_COUNT);
+    map_texture_id = state.resources->texture("assets/tileset.png");
+    fireball_small_texture_id = state.resources->texture("assets/fireball_small.png");
+    fireball_large_texture_id = state.resources->texture("assets/fireball_large.png");
 
     state.next_scene_id = -1;
 
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, EncounterB_DATA, map_texture_id, 1.0f, 4, 1);
+    this->state.map = arena.create<Map>(new Level("levels/encounterB.lvl"), map_texture_id, state.resources);
 
     // Code from main.cpp's initialise()
     /**
      George's Stuff
      */
      // Existing
-    state.player = new Entity();
+    state.player = arena.create<Entity>();
     state.player->set_entity_type(PLAYER);
-    state.player->set_position(glm::vec3(5.0f, -3.5f, 0.0f));
+    state.player->set_position(player_spawn());
     state.player->set_movement(glm::vec3(0.0f));
     state.player->speed = 3.5f;
     state.player->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/pokeball.png");
+    state.player->texture_id = state.resources->texture("assets/pokeball.png");
     state.player->height = 0.8f;
     state.player->width = 0.8f;
 
@@ -77,25 +70,34 @@ void EncounterB::initialise() {
     /**
      BGM and SFX
      */
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
+    //state.bgm = state.resources->music("assets/marnie.mp3");
+    //state.resources->play_music(state.bgm);
+    //state.resources->set_music_volume(80);
 
-    //state.bgm = Mix_LoadMUS("assets/marnie.mp3");
-    //Mix_PlayMusic(state.bgm, -1);
-    //Mix_VolumeMusic(80.0f);
+    state.jump_sfx = state.resources->sound("assets/bounce.wav");
+    state.win_sfx = state.resources->sound("assets/win.wav");
+    state.lose_sfx = state.resources->sound("assets/lose.wav");
 
-    state.jump_sfx = Mix_LoadWAV("assets/bounce.wav");
-    state.win_sfx = Mix_LoadWAV("assets/win.wav");
-    state.lose_sfx = Mix_LoadWAV("assets/lose.wav");
+    timeline.clear();
+    timeline.start(spawner());
+    timeline.start(script());
 }
 
-void EncounterB::update(float delta_time) {
-    passed_time += delta_time;
-    LOG(fmod(passed_time, 2.0f));
+ScriptTask EncounterB::script()
+{
+    co_await seconds(12.0f);
+    state.next_scene_id = 1;
+}
+
+ScriptTask EncounterB::spawner()
+{
+    // Phase 1: small fireballs from the left, level with the player
+    timeline.begin_phase(15.0f);
 
-    // Phase 1
-    if (passed_time < 15.0f && passed_time - prevSpawnTime > 0.25f) {
-        prevSpawnTime = passed_time;
-        Entity* ball1 = new Entity();
+    while (timeline.get_time() < timeline.get_phase_end_time()) {
+        co_await seconds(0.25f);
+
+        Entity* ball1 = arena.create<Entity>();
         ball1->set_entity_type(ENEMY);
         ball1->set_ai_type(STANDER);
         ball1->set_ai_state(IDLE);
@@ -109,27 +111,26 @@ void EncounterB::update(float delta_time) {
         ball1->width = 0.2f;
         state.vec_enemies.push_back(ball1);
     }
+}
 
-    if (passed_time > 12.0f) {
-        state.next_scene_id = 1;
-    }
+void EncounterB::update(float delta_time) {
+    PROFILE_ZONE("EncounterB::update");
+    COUNTER_SET(COUNTER_ENTITIES, live_entity_count());
+
+    timeline.update(delta_time);
 
     this->state.player->update(delta_time, state.player, state.vec_enemies, state.vec_enemies.size(), this->state.map);
     //LOG("Player: " << state.player->get_position().x << " " << state.player->get_position().y);
 
-    for (size_t i = 0; i < state.vec_enemies.size(); i++) {
-        auto enemy = state.vec_enemies.at(i);
-        //LOG("Enemy " << i << ": " << enemy->get_position().x << " " << enemy->get_position().y);
-        state.vec_enemies.at(i)->update(delta_time, state.player, state.vec_enemies, state.vec_enemies.size(), this->state.map);
-    }
+    fireball_update.update(delta_time, state.player, state.vec_enemies, this->state.map, state.jobs);
 }
 
-void EncounterB::render(ShaderProgram* program)
+void EncounterB::snapshot(RenderSnapshot* snapshot)
 {
-    this->state.map->render(program);
-    this->state.player->render(program);
+    this->state.map->snapshot(snapshot);
+    this->state.player->snapshot(snapshot);
 
     for (int i = 0; i < state.vec_enemies.size(); i++) {
-        state.vec_enemies.at(i)->render(program);
+        state.vec_enemies.at(i)->snapshot(snapshot);
     }
 }
@@ -1,21 +1,26 @@
 #include "Scene.h"
+#include "Script.h"
+#include "PhasedUpdate.h"
 
 class EncounterB : public Scene {
 public:
     int ENEMY_COUNT = 6;
     
-    ~EncounterB();
-
     bool played = false;
     
     void initialise() override;
+    void unload() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
+    void snapshot(RenderSnapshot *snapshot) override;
 
     GLuint map_texture_id;
     GLuint fireball_small_texture_id;
     GLuint fireball_large_texture_id;
 
-    float passed_time = 0.0f;
-    float prevSpawnTime = 0.0f;
+    Timeline timeline;
+    PhasedUpdate fireball_update;
+
+private:
+    ScriptTask script();
+    ScriptTask spawner();
 };
@@ -12,6 +12,7 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
 #include "Entity.h"
+#include "Counters.h"
 
 Entity::Entity()
 {
@@ -26,53 +27,6 @@ Entity::Entity()
     counter = 0;
 }
 
-Entity::~Entity()
-{
-    delete [] animation_up;
-    delete [] animation_down;
-    delete [] animation_left;
-    delete [] animation_right;
-    delete [] walking;
-}
-
-void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index)
-{
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float) (index % animation_cols) / (float) animation_cols;
-    float v_coord = (float) (index / animation_cols) / (float) animation_rows;
-    
-    // Step 2: Calculate its UV size
-    float width = 1.0f / (float) animation_cols;
-    float height = 1.0f / (float) animation_rows;
-    
-    // Step 3: Just as we have done before, match the texture coordinates to the vertices
-    float tex_coords[] =
-    {
-        u_coord, v_coord + height, u_coord + width, v_coord + height, u_coord + width, v_coord,
-        u_coord, v_coord + height, u_coord + width, v_coord, u_coord, v_coord
-    };
-    
-    float vertices[] =
-    {
-        -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
-        -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
-    };
-    
-    // Step 4: And render
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->positionAttribute);
-    
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->texCoordAttribute);
-    
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
-}
-
 void Entity::activate_ai(Entity *player) {
     switch (ai_type) {
         case WALKER:
@@ -177,13 +131,19 @@ void Entity::update(float delta_time, Entity *player, Entity *objects, int objec
     // Now we add the rest of the gravity physics
     velocity += acceleration * delta_time;
     
-    position.x += velocity.x * delta_time;
-    Entity* collided_x = check_collision_x(objects, object_count);
-    check_collision_x(map);
-
-    position.y += velocity.y * delta_time;
-    Entity* collided_y = check_collision_y(objects, object_count);
-    check_collision_y(map);
+    Entity* collided_x;
+    Entity* collided_y;
+    {
+        PROFILE_ZONE("collision");
+        
+        position.x += velocity.x * delta_time;
+        collided_x = check_collision_x(objects, object_count);
+        check_collision_x(map);
+        
+        position.y += velocity.y * delta_time;
+        collided_y = check_collision_y(objects, object_count);
+        check_collision_y(map);
+    }
 
     // Y Collision
     if (collided_y != nullptr) {
@@ -213,7 +173,7 @@ void Entity::update(float delta_time, Entity *player, Entity *objects, int objec
     model_matrix = glm::scale(model_matrix, glm::vec3(width, height, 1.0f));
 }
 
-void Entity::update(float delta_time, Entity* player, std::vector<Entity*> objects, int object_count, Map* map) {
+void Entity::update(float delta_time, Entity* player, const std::vector<Entity*> &objects, int object_count, Map* map) {
     if (!is_active) return;
 
     collided_top = false;
@@ -253,13 +213,19 @@ void Entity::update(float delta_time, Entity* player, std::vector<Entity*> objec
     // Now we add the rest of the gravity physics
     velocity += acceleration * delta_time;
 
-    position.x += velocity.x * delta_time;
-    Entity* collided_x = check_collision_x(objects, object_count);
-    check_collision_x(map);
-
-    position.y += velocity.y * delta_time;
-    Entity* collided_y = check_collision_y(objects, object_count);
-    check_collision_y(map);
+    Entity* collided_x;
+    Entity* collided_y;
+    {
+        PROFILE_ZONE("collision");
+        
+        position.x += velocity.x * delta_time;
+        collided_x = check_collision_x(objects, object_count);
+        check_collision_x(map);
+        
+        position.y += velocity.y * delta_time;
+        collided_y = check_collision_y(objects, object_count);
+        check_collision_y(map);
+    }
 
     if ((collided_y != nullptr || collided_x != nullptr)
         && (collided_y == player || collided_x == player
@@ -283,6 +249,70 @@ void Entity::update(float delta_time, Entity* player, std::vector<Entity*> objec
 
 }
 
+void Entity::integrate(float delta_time, Entity *player, Map *map)
+{
+    if (!is_active) return;
+
+    collided_top    = false;
+    collided_bottom = false;
+    collided_left   = false;
+    collided_right  = false;
+
+    if (entity_type == ENEMY) activate_ai(player);
+
+    if (animation_indices != NULL && glm::length(movement) != 0)
+    {
+        animation_time += delta_time;
+        float frames_per_second = (float) 1 / SECONDS_PER_FRAME;
+
+        if (animation_time >= frames_per_second / 2)
+        {
+            animation_time = 0.0f;
+            animation_index++;
+
+            if (animation_index >= animation_frames) animation_index = 0;
+        }
+    }
+
+    velocity.x = movement.x * speed;
+
+    if (acceleration.y == 0) {
+        velocity.y = movement.y * speed;
+    }
+
+    velocity += acceleration * delta_time;
+
+    position.x += velocity.x * delta_time;
+    check_collision_x(map);
+
+    position.y += velocity.y * delta_time;
+    check_collision_y(map);
+
+    if (is_jumping)
+    {
+        is_jumping = false;
+        velocity.y += jumping_power;
+    }
+
+    model_matrix = glm::mat4(1.0f);
+    model_matrix = glm::translate(model_matrix, position);
+    model_matrix = glm::scale(model_matrix, glm::vec3(width, height, 1.0f));
+}
+
+bool Entity::register_contact()
+{
+    // Same rules as check_collision_x/y on an entity list: moving is what makes a touch a hit
+    bool hit = false;
+
+    if (velocity.y > 0)      { collided_top    = true; hit = true; }
+    else if (velocity.y < 0) { collided_bottom = true; hit = true; }
+
+    if (velocity.x > 0)      { collided_right  = true; hit = true; }
+    else if (velocity.x < 0) { collided_left   = true; hit = true; }
+
+    return hit;
+}
+
 Entity* const Entity::check_collision_y(Entity *collidable_entities, int collidable_entity_count)
 {
     for (int i = 0; i < collidable_entity_count; i++)
@@ -309,7 +339,7 @@ Entity* const Entity::check_collision_y(Entity *collidable_entities, int collida
     return nullptr;
 }
 
-Entity* const Entity::check_collision_y(std::vector<Entity*> collidable_entities, int collidable_entity_count)
+Entity* const Entity::check_collision_y(const std::vector<Entity*> &collidable_entities, int collidable_entity_count)
 {
     for (int i = 0; i < collidable_entity_count; i++)
     {
@@ -336,7 +366,7 @@ Entity* const Entity::check_collision_y(std::vector<Entity*> collidable_entities
     return nullptr;
 }
 
-Entity* const Entity::check_collision_x(std::vector<Entity*> collidable_entities, int collidable_entity_count)
+Entity* const Entity::check_collision_x(const std::vector<Entity*> &collidable_entities, int collidable_entity_count)
 {
     for (int i = 0; i < collidable_entity_count; i++)
     {
@@ -391,6 +421,9 @@ Entity* const Entity::check_collision_x(Entity *collidable_entities, int collida
 
 void const Entity::check_collision_y(Map *map)
 {
+    // Nowhere near a solid tile, so none of the probes below could find one
+    if (!map->touches_solid(position, width, height)) return;
+    
     // Probes for tiles
     glm::vec3 top = glm::vec3(position.x, position.y + (height / 2), position.z);
     glm::vec3 top_left = glm::vec3(position.x - (width / 2), position.y + (height / 2), position.z);
@@ -445,6 +478,8 @@ void const Entity::check_collision_y(Map *map)
 
 void const Entity::check_collision_x(Map *map)
 {
+    if (!map->touches_solid(position, width, height)) return;
+    
     // Probes for tiles
     glm::vec3 left = glm::vec3(position.x - (width / 2), position.y, position.z);
     glm::vec3 right = glm::vec3(position.x + (width / 2), position.y, position.z);
@@ -466,36 +501,23 @@ void const Entity::check_collision_x(Map *map)
     }
 }
 
-void Entity::render(ShaderProgram *program)
+void Entity::snapshot(RenderSnapshot *snapshot) const
 {
     if (!is_active) return;
     
-    program->SetModelMatrix(model_matrix);
-    
     if (animation_indices != NULL)
     {
-        draw_sprite_from_texture_atlas(program, texture_id, animation_indices[animation_index]);
+        snapshot->add_sprite(texture_id, model_matrix, animation_indices[animation_index], animation_cols, animation_rows);
         return;
     }
     
-    float vertices[]   = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = {  0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
-    
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->texCoordAttribute);
-    
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    snapshot->add_sprite(texture_id, model_matrix);
 }
 
 bool const Entity::check_collision(Entity *other) const
 {
+    COUNTER_ADD(COUNTER_COLLISION_TESTS, 1);
+    
     // If we are checking with collisions with ourselves, this should be false
     if (other == this) return false;
     
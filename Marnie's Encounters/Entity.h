@@ -1,5 +1,6 @@
 #pragma once
 #include "Map.h"
+#include "Snapshot.h"
 #include <iostream>
 #include <vector>
 
@@ -14,11 +15,6 @@ private:
     AIType ai_type;
     AIState ai_state;
     
-    int *animation_right = NULL; // move to the right
-    int *animation_left  = NULL; // move to the left
-    int *animation_up    = NULL; // move upwards
-    int *animation_down  = NULL; // move downwards
-    
     glm::vec3 position;
     glm::vec3 velocity;
     glm::vec3 acceleration;
@@ -49,7 +45,8 @@ public:
     int lives;
     
     // Animating
-    int **walking          = new int*[4] { animation_left, animation_right, animation_up, animation_down };
+    // Frame tables by direction (LEFT, RIGHT, UP, DOWN); the scene's arena owns them
+    int *walking[4]        = { NULL, NULL, NULL, NULL };
     int *animation_indices = NULL;
     int animation_frames   = 0;
     int animation_index    = 0;
@@ -71,12 +68,16 @@ public:
 
     // Methods
     Entity();
-    ~Entity();
 
-    void draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index);
     void update(float delta_time, Entity *player, Entity *objects, int object_count, Map *map);
-    void update(float delta_time, Entity* player, std::vector<Entity*> objects, int object_count, Map* map);
-    void render(ShaderProgram *program);
+    void update(float delta_time, Entity* player, const std::vector<Entity*> &objects, int object_count, Map* map);
+    void snapshot(RenderSnapshot *snapshot) const;
+    
+    // The first phase of a PhasedUpdate: AI, animation, movement and the map, touching nothing but this entity
+    void integrate(float delta_time, Entity *player, Map *map);
+    // Sets the collided_ flags for touching another entity; true if that counts as a collision the way update() sees it
+    bool register_contact();
+    
     void activate_ai(Entity *player);
     void ai_walker();
     void ai_guard(Entity *player);
@@ -84,8 +85,8 @@ public:
     
     Entity* const check_collision_y(Entity *collidable_entities, int collidable_entity_count);
     Entity* const check_collision_x(Entity *collidable_entities, int collidable_entity_count);
-    Entity* const check_collision_y(std::vector<Entity*> collidable_entities, int collidable_entity_count);
-    Entity* const check_collision_x(std::vector<Entity*> collidable_entities, int collidable_entity_count);
+    Entity* const check_collision_y(const std::vector<Entity*> &collidable_entities, int collidable_entity_count);
+    Entity* const check_collision_x(const std::vector<Entity*> &collidable_entities, int collidable_entity_count);
     void const check_collision_y(Map *map);
     void const check_collision_x(Map *map);
     
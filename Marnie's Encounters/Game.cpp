@@ -0,0 +1,192 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Game.h"
+#include "Profiler.h"
+#include "Counters.h"
+#include "Allocations.h"
+#include "Memory.h"
+#include "World.h"
+#include "EncounterA.h"
+#include "EncounterB.h"
+#include "Menu.h"
+#include <iostream>
+
+const float PLAYER_LIGHT_RADIUS    = 16.0f,
+            PLAYER_LIGHT_INTENSITY = 1.0f;
+
+const char* const SCENE_NAMES[SCENE_COUNT] = { "menu", "world", "encounterA", "encounterB" };
+
+Game::Game(Resources *resources, JobSystem *jobs, uint64_t seed)
+{
+    this->resources = resources;
+    this->jobs = jobs;
+    this->seed = seed;
+    this->random.seed(seed);
+
+    this->levels[SCENE_MENU]        = new Menu();
+    this->levels[SCENE_WORLD]       = new World();
+    this->levels[SCENE_ENCOUNTER_A] = new EncounterA();
+    this->levels[SCENE_ENCOUNTER_B] = new EncounterB();
+    for (int i = 0; i < SCENE_COUNT; i++) this->levels[i]->name = SCENE_NAMES[i];
+
+    switch_to_scene(SCENE_MENU);
+    get_current_scene()->state.player->lives = 1;
+}
+
+Game::~Game()
+{
+    for (int i = 0; i < SCENE_COUNT; i++) delete this->levels[i];
+}
+
+void Game::switch_to_scene(SceneId scene_id)
+{
+    PROFILE_ZONE("switch_to_scene");
+
+    // Re-entering a scene starts it over, so it is unloaded whether or not it is the one we're going to
+    get_current_scene()->unload();
+    this->current_scene_id = scene_id;
+
+    Scene *scene = get_current_scene();
+    scene->state.lighting = &this->lighting;
+    scene->state.random = &this->random;
+    scene->state.resources = this->resources;
+    scene->state.jobs = this->jobs;
+    this->lighting.clear_static_lights();
+    
+    {
+        // Textures and sounds loaded here are charged to this scene
+        MemoryOwner owner(scene->name);
+        scene->initialise(); // DON'T FORGET THIS STEP!
+    }
+    
+    // Loading allocates, and so do the first frames of a scene while its vectors find their size
+    ALLOC_WARM_UP();
+}
+
+void Game::apply_input(InputFrame input)
+{
+    Scene *scene = get_current_scene();
+    Entity *player = scene->state.player;
+
+    // VERY IMPORTANT: If nothing is pressed, we don't want to go anywhere
+    player->set_movement(glm::vec3(0.0f));
+
+    if (input.is_down(INPUT_JUMP) && player->collided_bottom) {
+        this->resources->play_sound(scene->state.jump_sfx);
+        player->is_jumping = true;
+    }
+
+    if (input.is_down(INPUT_START) && this->current_scene_id == SCENE_MENU) {
+        scene->state.next_scene_id = SCENE_WORLD;
+    }
+
+    // Supports WASD and Arrow Keys
+    if (input.is_down(INPUT_LEFT))
+    {
+        player->movement.x = -1.0f;
+        player->animation_indices = player->walking[player->LEFT];
+    }
+    else if (input.is_down(INPUT_RIGHT))
+    {
+        player->movement.x = 1.0f;
+        player->animation_indices = player->walking[player->RIGHT];
+    }
+    else if (input.is_down(INPUT_UP) && this->current_scene_id != SCENE_WORLD)
+    {
+        player->movement.y = 1.0f;
+        player->animation_indices = player->walking[player->UP];
+    }
+    else if (input.is_down(INPUT_DOWN) && this->current_scene_id != SCENE_WORLD)
+    {
+        player->movement.y = -1.0f;
+        player->animation_indices = player->walking[player->DOWN];
+    }
+
+    if (glm::length(player->movement) > 1.0f)
+    {
+        player->movement = glm::normalize(player->movement);
+    }
+}
+
+void Game::step(InputFrame input)
+{
+    PROFILE_ZONE("step");
+    COUNTER_ADD(COUNTER_SIM_STEPS, 1);
+
+    apply_input(input);
+
+    Scene *scene = get_current_scene();
+    {
+        // Streaming bakes lightmaps as it goes
+        MemoryOwner owner(scene->name);
+        scene->update(FIXED_TIMESTEP);
+    }
+    this->steps_taken++;
+
+    // Scene changes happen inside the step so that a replay changes scene on the same step
+    if (scene->state.next_scene_id >= 0) {
+        int lives = scene->state.player->lives;
+        switch_to_scene((SceneId) scene->state.next_scene_id);
+        get_current_scene()->state.player->lives = lives;
+    }
+    
+    // A step is the simulation's frame, as far as the allocation budget goes
+    ALLOC_FRAME_END();
+}
+
+void Game::snapshot(RenderSnapshot *out)
+{
+    PROFILE_ZONE("snapshot");
+
+    Scene *scene = get_current_scene();
+    glm::vec3 player_position = scene->state.player->get_position();
+
+    out->clear();
+    out->scene_id = this->current_scene_id;
+    out->steps_taken = this->steps_taken;
+    out->is_static = scene->is_static();
+
+    // Prevent the camera from showing anything outside of the "edge" of the level
+    const Level *level = scene->state.map->get_level();
+    bool camera_fixed = level->get_property("camera_fixed", 0.0f) != 0.0f;
+    
+    if (player_position.x > level->get_property("camera_left_edge", 0.0f) && !camera_fixed) {
+        out->view_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(-player_position.x, 3.75f, 0));
+    }
+    else {
+        out->view_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(-5, 3.75, 0));
+    }
+
+    // The player carries a light everywhere but the menu
+    Light player_light;
+    player_light.position  = this->current_scene_id != SCENE_MENU ? glm::vec2(player_position) : glm::vec2(3.5f, 3.5f);
+    player_light.radius    = PLAYER_LIGHT_RADIUS;
+    player_light.intensity = PLAYER_LIGHT_INTENSITY;
+
+    this->lighting.clear_dynamic_lights();
+    this->lighting.add_dynamic_light(player_light);
+    scene->add_lights(&this->lighting);
+    out->lights = this->lighting.get_dynamic_lights();
+
+    scene->snapshot(out);
+
+    // Everything the simulation counted since the previous snapshot
+    Counters::end_frame();
+    for (int i = 0; i < COUNTER_COUNT; i++) out->counters[i] = Counters::get_last_frame((EngineCounter) i);
+}
+
+void Game::report() const
+{
+    Entity *player = get_current_scene()->state.player;
+
+    LOG("steps: " << this->steps_taken << ", seed: " << this->seed);
+    LOG("scene: " << SCENE_NAMES[this->current_scene_id]);
+    LOG("player: " << player->get_position().x << " " << player->get_position().y << (player->is_active ? " alive" : " dead"));
+    LOG("entities: " << get_current_scene()->live_entity_count());
+}
+
+void Game::report_memory() const
+{
+    for (int i = 0; i < SCENE_COUNT; i++) this->levels[i]->account_memory();
+    Memory::report();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "Scene.h"
+#include "Lighting.h"
+#include "Random.h"
+#include "Resources.h"
+#include "Input.h"
+#include "Jobs.h"
+#include "Snapshot.h"
+
+#define FIXED_TIMESTEP 0.0166666f
+
+enum SceneId { SCENE_MENU, SCENE_WORLD, SCENE_ENCOUNTER_A, SCENE_ENCOUNTER_B, SCENE_COUNT };
+
+// One complete, independent run of the game: its scenes, its randomness and its lighting.
+// Nothing here is global, so a process can step as many of these side by side as it likes;
+// windows, shaders and the clock stay with whoever owns the Game.
+class Game {
+    Scene *levels[SCENE_COUNT];
+    SceneId current_scene_id = SCENE_MENU;  // Unloading a scene that was never initialised does nothing
+
+    Lighting lighting;
+    RandomService random;
+    Resources *resources;
+    JobSystem *jobs;
+
+    uint64_t seed;
+    int steps_taken = 0;
+
+    void switch_to_scene(SceneId scene_id);
+    void apply_input(InputFrame input);
+
+public:
+    Game(Resources *resources, JobSystem *jobs, uint64_t seed);
+    ~Game();
+
+    // One fixed step of the whole game, driven only by that step's input
+    void step(InputFrame input);
+
+    // Copies out everything the current scene wants drawn, plus the camera and the lights
+    void snapshot(RenderSnapshot *out);
+
+    // Prints where the run ended up; two replays of the same recording must print the same thing
+    void report() const;
+
+    // Prints what every scene and the resources they loaded hold; simulation thread only
+    void report_memory() const;
+
+    Scene *get_current_scene() const { return this->levels[this->current_scene_id]; };
+    SceneId const get_current_scene_id() const { return this->current_scene_id; };
+    Lighting *get_lighting() { return &this->lighting; };
+    RandomService &get_random() { return this->random; };
+    uint64_t const get_seed() const { return this->seed; };
+    int const get_steps_taken() const { return this->steps_taken; };
+};
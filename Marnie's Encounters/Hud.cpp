@@ -0,0 +1,62 @@
+#include "Hud.h"
+#include "Utility.h"
+#include "Counters.h"
+#include <stdio.h>
+
+#define HUD_FONT_SIZE 0.25f
+#define HUD_LINE_HEIGHT 0.3f
+
+const glm::vec3 HUD_ORIGIN = glm::vec3(-4.7f, 3.45f, 0.0f);
+
+Hud::Hud(glm::mat4 projection_matrix, Resources *resources)
+{
+    // Unlit, so the numbers stay readable in the dark; the view never moves, it's screen space
+    program = ShaderProgram::Get(SHADER_VERTEX_TEXTURED, SHADER_FRAGMENT_TEXTURED);
+    program->SetProjectionMatrix(projection_matrix);
+    program->SetViewMatrix(glm::mat4(1.0f));
+
+    this->resources = resources;
+    this->font_texture_id = resources->texture("assets/font1.png");
+    this->frame_time = 0.0f;
+    for (int i = 0; i < COUNTER_COUNT; i++) this->simulation_counters[i] = 0;
+}
+
+void Hud::update(float frame_time, const int *simulation_counters)
+{
+    this->frame_time = frame_time;
+    for (int i = 0; i < COUNTER_COUNT; i++) this->simulation_counters[i] = simulation_counters[i];
+}
+
+void Hud::render()
+{
+    if (!this->visible) return;
+
+    char line[64];
+    glm::vec3 position = HUD_ORIGIN;
+
+    snprintf(line, sizeof(line), "frame %.2f ms", this->frame_time * 1000.0f);
+    Utility::draw_text(this->program, this->resources, this->font_texture_id, line, HUD_FONT_SIZE, 0.0f, position, &this->text_vertices);
+
+    if (this->latency != nullptr)
+    {
+        position.y -= HUD_LINE_HEIGHT;
+
+        if (this->latency->get_count() == 0) snprintf(line, sizeof(line), "input latency -");
+        else snprintf(line, sizeof(line), "input latency p50 %d p99 %d ms", this->latency->percentile(0.5f), this->latency->percentile(0.99f));
+        Utility::draw_text(this->program, this->resources, this->font_texture_id, line, HUD_FONT_SIZE, 0.0f, position, &this->text_vertices);
+    }
+
+#ifdef PROFILER_ENABLED
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        EngineCounter counter = (EngineCounter) i;
+        position.y -= HUD_LINE_HEIGHT;
+
+        snprintf(line, sizeof(line), "%s %d", Counters::get_name(counter), Counters::get_last_frame(counter) + this->simulation_counters[i]);
+        Utility::draw_text(this->program, this->resources, this->font_texture_id, line, HUD_FONT_SIZE, 0.0f, position, &this->text_vertices);
+    }
+#else
+    position.y -= HUD_LINE_HEIGHT;
+    Utility::draw_text(this->program, this->resources, this->font_texture_id, "counters off in this build", HUD_FONT_SIZE, 0.0f, position, &this->text_vertices);
+#endif
+}
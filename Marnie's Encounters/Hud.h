@@ -0,0 +1,41 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "Resources.h"
+#include "Utility.h"
+#include "Counters.h"
+#include "Latency.h"
+
+// Performance overlay drawn in screen space over everything else
+class Hud {
+    ShaderProgram *program;     // Owned by the program cache
+    Resources *resources;
+    GLuint font_texture_id;
+    TextVertices text_vertices;
+    float frame_time;
+
+    // The simulation thread's counters from the snapshot being shown; the render thread's own are added on top
+    int simulation_counters[COUNTER_COUNT];
+
+    const LatencyHistogram *latency = nullptr;
+
+public:
+    bool visible = false;
+
+    Hud(glm::mat4 projection_matrix, Resources *resources);
+
+    void toggle() { visible = !visible; };
+    void update(float frame_time, const int *simulation_counters);
+    void show_latency(const LatencyHistogram *latency) { this->latency = latency; };
+    void render();
+};
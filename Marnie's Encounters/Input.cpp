@@ -0,0 +1,135 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Input.h"
+#include <iostream>
+#include <string.h>
+
+void LiveInput::push(InputEvent event)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->events.push_back(event);
+}
+
+bool LiveInput::next(InputFrame &frame)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // Anything that went down during the step counts for it, even if it came back up before the step
+    // was over; a tap shorter than a frame still jumps. Presses only count once, however many steps follow.
+    uint8_t pressed = 0;
+
+    size_t taken = 0;
+    while (taken < this->events.size() && this->events[taken].timestamp <= this->step_time)
+    {
+        const InputEvent &event = this->events[taken++];
+        if (this->first_taken == 0) this->first_taken = event.timestamp;
+
+        if (event.down)
+        {
+            pressed |= event.button;
+            if ((event.button & INPUT_PRESS_ONLY) == 0) this->held |= event.button;
+        }
+        else
+        {
+            this->held &= ~event.button;
+        }
+    }
+    this->events.erase(this->events.begin(), this->events.begin() + taken);
+
+    frame.buttons = this->held | pressed;
+    return true;
+}
+
+uint32_t LiveInput::take_first_taken()
+{
+    uint32_t timestamp = this->first_taken;
+    this->first_taken = 0;
+
+    return timestamp;
+}
+
+InputRecorder::InputRecorder(InputStream *source, const char *filepath, uint64_t seed)
+{
+    this->source = source;
+    this->outfile.open(filepath, std::ios::binary);
+
+    if (outfile.fail())
+    {
+        LOG("Unable to record input to " << filepath);
+        return;
+    }
+
+    InputFileHeader header;
+    memcpy(header.magic, INPUT_FILE_MAGIC, sizeof(header.magic));
+    header.version = INPUT_FILE_VERSION;
+    header.seed = seed;
+
+    outfile.write((const char*) &header, sizeof(header));
+}
+
+InputRecorder::~InputRecorder()
+{
+    flush_run();
+}
+
+void InputRecorder::flush_run()
+{
+    if (run_length == 0 || !outfile.is_open()) return;
+
+    outfile.put((char) run_buttons);
+    outfile.put((char) run_length);
+    run_length = 0;
+}
+
+bool InputRecorder::next(InputFrame &frame)
+{
+    if (!source->next(frame)) return false;
+
+    // Most steps repeat the one before, so runs of identical input are stored as one pair
+    if (run_length == 255 || (run_length > 0 && frame.buttons != run_buttons)) flush_run();
+
+    run_buttons = frame.buttons;
+    run_length++;
+
+    return true;
+}
+
+InputReplay::InputReplay(const char *filepath)
+{
+    infile.open(filepath, std::ios::binary);
+
+    if (infile.fail())
+    {
+        LOG("Unable to open input recording " << filepath);
+        return;
+    }
+
+    infile.read((char*) &header, sizeof(header));
+
+    if (!infile || memcmp(header.magic, INPUT_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != INPUT_FILE_VERSION)
+    {
+        LOG(filepath << " is not an input recording this build can play");
+        infile.close();
+    }
+}
+
+bool InputReplay::next(InputFrame &frame)
+{
+    if (run_length == 0)
+    {
+        if (!infile.is_open()) return false;
+
+        char pair[2];
+        if (!infile.read(pair, sizeof(pair))) return false;
+
+        run_buttons = (uint8_t) pair[0];
+        run_length = (uint8_t) pair[1];
+        
+        if (run_length == 0) return false;
+    }
+
+    frame.buttons = run_buttons;
+    run_length--;
+
+    return true;
+}
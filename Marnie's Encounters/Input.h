@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+// Everything a fixed step needs to know about the player's input, packed into one byte
+enum InputButton
+{
+    INPUT_LEFT  = 1 << 0,
+    INPUT_RIGHT = 1 << 1,
+    INPUT_UP    = 1 << 2,
+    INPUT_DOWN  = 1 << 3,
+    INPUT_JUMP  = 1 << 4,   // Pressed during this step, not held
+    INPUT_START = 1 << 5    // Pressed during this step, not held
+};
+
+// Buttons that are only ever pressed, never held down across steps
+const uint8_t INPUT_PRESS_ONLY = INPUT_JUMP | INPUT_START;
+
+struct InputFrame
+{
+    uint8_t buttons;
+
+    bool const is_down(InputButton button) const { return (buttons & button) != 0; };
+};
+
+// Recordings start with this header, followed by (buttons, run length) byte pairs
+struct InputFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;      // What the randomness was seeded with when the recording started
+};
+
+const char INPUT_FILE_MAGIC[4] = { 'M', 'R', 'I', 'N' };
+const uint32_t INPUT_FILE_VERSION = 1;
+
+class InputStream {
+public:
+    virtual ~InputStream() {}
+
+    // Hands out the input for the next fixed step; false once there is none left (end of a replay)
+    virtual bool next(InputFrame &frame) = 0;
+};
+
+// A button going down or up, stamped with when it happened on SDL's millisecond clock
+struct InputEvent
+{
+    uint32_t timestamp;
+    InputButton button;
+    bool down;
+};
+
+// Input from the keyboard, as a queue of timestamped events. process_input pushes them as it polls;
+// each fixed step takes only the events up to its own time, so a step sees the keys as they were
+// when it was due rather than whenever the frame happened to poll. The two sides may be on different threads.
+class LiveInput : public InputStream {
+    std::mutex mutex;
+    std::vector<InputEvent> events;     // Oldest first, not yet taken by any step
+
+    // Stepping side only
+    uint8_t held = 0;
+    uint32_t step_time = UINT32_MAX;    // Until a clock is given, every step takes everything queued
+    uint32_t first_taken = 0;           // Oldest event taken since take_first_taken(); 0 for none
+
+public:
+    void push(InputEvent event);
+
+    // The time (on the events' clock) that the next step is due
+    void set_step_time(uint32_t timestamp) { step_time = timestamp; };
+
+    bool next(InputFrame &frame) override;
+
+    // Stepping side: the timestamp of the oldest event steps have taken since the last call, or 0.
+    // That event is first on screen in whichever frame is simulated next.
+    uint32_t take_first_taken();
+};
+
+// Passes another stream (which it doesn't own) through untouched while writing every step of it to disk
+class InputRecorder : public InputStream {
+    InputStream *source;
+    std::ofstream outfile;
+
+    uint8_t run_buttons = 0;
+    uint8_t run_length = 0;
+
+    void flush_run();
+
+public:
+    InputRecorder(InputStream *source, const char *filepath, uint64_t seed);
+    ~InputRecorder();
+
+    bool next(InputFrame &frame) override;
+};
+
+// Plays a recording back, one step at a time
+class InputReplay : public InputStream {
+    std::ifstream infile;
+    InputFileHeader header;
+
+    uint8_t run_buttons = 0;
+    uint8_t run_length = 0;
+
+public:
+    InputReplay(const char *filepath);
+
+    bool const is_valid() const { return infile.is_open(); };
+    uint64_t const get_seed() const { return header.seed; };
+
+    bool next(InputFrame &frame) override;
+};
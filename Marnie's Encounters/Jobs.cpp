@@ -0,0 +1,176 @@
+#include "Jobs.h"
+#include "Profiler.h"
+
+// Which queue this thread owns; threads outside the pool share the last one
+static thread_local int worker_index = -1;
+
+JobSystem::JobSystem(int worker_count)
+{
+    if (worker_count < 0) worker_count = (int) std::thread::hardware_concurrency() - 1;
+    if (worker_count < 0) worker_count = 0;
+
+    queued = 0;
+    stopping = false;
+
+    for (int i = 0; i <= worker_count; i++) queues.push_back(new JobQueue());
+    for (int i = 0; i < worker_count; i++) workers.push_back(std::thread(&JobSystem::worker_loop, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    for (size_t i = 0; i < queues.size(); i++) delete queues[i];
+}
+
+int const JobSystem::own_queue() const
+{
+    return worker_index >= 0 ? worker_index : (int) queues.size() - 1;
+}
+
+void JobSystem::push(int queue, const Job &job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->jobs.push_back(job);
+    }
+    queued++;
+}
+
+bool JobSystem::pop(int queue, Job &job)
+{
+    std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+    if (queues[queue]->jobs.empty()) return false;
+
+    // Newest first: it was cut from the range this thread is already working on
+    job = queues[queue]->jobs.back();
+    queues[queue]->jobs.pop_back();
+    queued--;
+    return true;
+}
+
+bool JobSystem::steal(int thief, Job &job)
+{
+    int count = (int) queues.size();
+
+    for (int i = 1; i < count; i++)
+    {
+        JobQueue *victim = queues[(thief + i) % count];
+
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (victim->jobs.empty()) continue;
+
+        // Oldest first, leaving the owner the slices it is most likely to want next
+        job = victim->jobs.front();
+        victim->jobs.pop_front();
+        queued--;
+        return true;
+    }
+
+    return false;
+}
+
+bool JobSystem::find_job(Job &job)
+{
+    int queue = own_queue();
+    return pop(queue, job) || steal(queue, job);
+}
+
+void JobSystem::run(const Job &job)
+{
+#ifdef PROFILER_ENABLED
+    // Another thread's slice is its work: what it counts goes back to that thread, not this one's frame
+    bool borrowed = job.owner != std::this_thread::get_id();
+
+    int saved_counters[COUNTER_COUNT];
+    if (borrowed) Counters::begin_slice(saved_counters);
+#endif
+#ifdef ALLOC_TRACKING_ENABLED
+    AllocationFold *previous_fold = borrowed ? Allocations::begin_slice(&job.fold->allocations) : nullptr;
+#endif
+
+    (*job.body)(job.begin, job.end);
+
+#ifdef ALLOC_TRACKING_ENABLED
+    if (borrowed) Allocations::end_slice(previous_fold);
+#endif
+#ifdef PROFILER_ENABLED
+    if (borrowed) Counters::end_slice(saved_counters, &job.fold->counters);
+#endif
+    (*job.remaining)--;
+}
+
+void JobSystem::worker_loop(int index)
+{
+    worker_index = index;
+
+    PROFILE_THREAD("worker");
+
+    while (true)
+    {
+        Job job;
+        if (find_job(job)) {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::parallel_for(int count, int grain, const std::function<void(int, int)> &body)
+{
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+
+    // Not worth waking anybody for
+    if (count <= grain || workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    int slices = (count + grain - 1) / grain;
+    std::atomic<int> remaining(slices);
+    JobFold fold {};
+
+    // Pushed back to front, so this thread's own pops start at slice 0
+    int queue = own_queue();
+    for (int s = slices - 1; s >= 0; s--)
+    {
+        Job job;
+        job.body = &body;
+        job.begin = s * grain;
+        job.end = s * grain + grain < count ? s * grain + grain : count;
+        job.remaining = &remaining;
+        job.owner = std::this_thread::get_id();
+        job.fold = &fold;
+        push(queue, job);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_all();
+
+    // Help out until every slice has finished, wherever it ran
+    while (remaining > 0)
+    {
+        Job job;
+        if (find_job(job)) run(job);
+        else std::this_thread::yield();
+    }
+
+#ifdef PROFILER_ENABLED
+    Counters::add_fold(&fold.counters);
+#endif
+#ifdef ALLOC_TRACKING_ENABLED
+    Allocations::add_fold(&fold.allocations);
+#endif
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Allocations.h"
+
+// What a parallel_for's slices counted and allocated on other threads, carried back to the thread that
+// called it, so its own end_frame() answers for all of its work
+struct JobFold
+{
+#ifdef PROFILER_ENABLED
+    CounterFold counters;
+#endif
+#ifdef ALLOC_TRACKING_ENABLED
+    AllocationFold allocations;
+#endif
+};
+
+// A slice of a parallel_for: run body over [begin, end), then count down remaining
+struct Job
+{
+    const std::function<void(int, int)> *body;
+    int begin, end;
+    std::atomic<int> *remaining;
+    std::thread::id owner;      // The thread that called parallel_for
+    JobFold *fold;
+};
+
+// Each thread pushes and pops its own jobs at the back; idle threads steal from the front of someone else's
+struct JobQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+// Fixed pool of worker threads sharing parallel_for slices by work stealing.
+// Slices are cut the same way whatever the thread count, and each writes only its own range,
+// so anything built on parallel_for gives the same answer on one core or sixteen.
+class JobSystem {
+    std::vector<std::thread> workers;
+
+    // One queue per worker, plus a last one shared by threads outside the pool
+    std::vector<JobQueue*> queues;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<int> queued;
+    std::atomic<bool> stopping;
+
+    int const own_queue() const;
+    void push(int queue, const Job &job);
+    bool pop(int queue, Job &job);
+    bool steal(int thief, Job &job);
+    bool find_job(Job &job);
+    void run(const Job &job);
+
+    void worker_loop(int index);
+
+public:
+    // -1 workers means one per core beyond the calling thread; 0 runs everything on the caller
+    JobSystem(int worker_count = -1);
+    ~JobSystem();
+
+    // Calls body(begin, end) over [0, count) in slices of at most grain, and returns once all are done.
+    // The calling thread works through slices too; counts no bigger than one slice never leave it.
+    void parallel_for(int count, int grain, const std::function<void(int, int)> &body);
+
+    int const get_thread_count() const { return (int) workers.size() + 1; };
+};
@@ -0,0 +1,39 @@
+#include "Latency.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (int i = 0; i < LATENCY_BUCKETS; i++) buckets[i] = 0;
+
+    sample_count = 0;
+    next_sample = 0;
+}
+
+void LatencyHistogram::add(uint32_t milliseconds)
+{
+    int bucket = milliseconds < LATENCY_BUCKETS ? (int) milliseconds : LATENCY_BUCKETS - 1;
+
+    // The window is full: the oldest sample makes room
+    if (sample_count == LATENCY_WINDOW) buckets[samples[next_sample]]--;
+    else sample_count++;
+
+    samples[next_sample] = (uint8_t) bucket;
+    buckets[bucket]++;
+    next_sample = (next_sample + 1) % LATENCY_WINDOW;
+}
+
+int const LatencyHistogram::percentile(float fraction) const
+{
+    if (sample_count == 0) return 0;
+
+    int wanted = (int) (fraction * sample_count + 0.5f);
+    if (wanted < 1) wanted = 1;
+
+    int seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += buckets[i];
+        if (seen >= wanted) return i;
+    }
+
+    return LATENCY_BUCKETS - 1;
+}
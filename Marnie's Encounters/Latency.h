@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+
+#define LATENCY_BUCKETS 100     // One millisecond each; the last also catches everything slower
+#define LATENCY_WINDOW  256     // Samples kept; older ones fall out of the histogram as new ones arrive
+
+// Rolling histogram of input-to-photon latency: from the SDL timestamp of a key event to the return
+// of the first SDL_GL_SwapWindow whose frame was simulated with it
+class LatencyHistogram {
+    int buckets[LATENCY_BUCKETS];
+
+    uint8_t samples[LATENCY_WINDOW];    // Bucket of each sample in the window, oldest at next_sample once full
+    int sample_count;
+    int next_sample;
+
+public:
+    LatencyHistogram();
+
+    void add(uint32_t milliseconds);
+
+    int const get_count() const { return sample_count; };
+
+    // Smallest latency that at least this fraction of the window came in at or under, in milliseconds
+    int const percentile(float fraction) const;
+};
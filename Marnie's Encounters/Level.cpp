@@ -0,0 +1,640 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Level.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+// Whether count items of item_size starting at offset lie inside a file of file_size bytes
+static bool fits(size_t file_size, uint32_t offset, size_t count, size_t item_size)
+{
+    return offset % 4 == 0 && offset <= file_size && count * item_size <= file_size - offset;
+}
+
+Level::Level(const char *filepath) : file(filepath), path(filepath)
+{
+    if (!file.is_open() || file.size() < sizeof(LevelFileHeader))
+    {
+        LOG("Unable to open level " << filepath);
+        return;
+    }
+
+    const LevelFileHeader *candidate = (const LevelFileHeader*) file.data();
+
+    if (memcmp(candidate->magic, LEVEL_FILE_MAGIC, sizeof(candidate->magic)) != 0 || candidate->version != LEVEL_FILE_VERSION)
+    {
+        LOG("Level " << filepath << " is not a version " << LEVEL_FILE_VERSION << " level; rebuild it with --build-level");
+        return;
+    }
+
+    size_t row_count = (size_t) candidate->height * candidate->layer_count;
+    bool layers_fit = false;
+
+    if (candidate->layer_encoding == LAYER_DENSE)
+    {
+        layers_fit = (candidate->tile_bytes == 1 || candidate->tile_bytes == 2)
+            && fits(file.size(), candidate->tiles_offset, row_count * candidate->width, candidate->tile_bytes);
+    }
+    else if (candidate->layer_encoding == LAYER_SPANS)
+    {
+        uint32_t spans_offset = candidate->tiles_offset + (uint32_t) ((row_count + 1) * sizeof(uint32_t));
+
+        layers_fit = fits(file.size(), candidate->tiles_offset, row_count + 1, sizeof(uint32_t))
+            && fits(file.size(), spans_offset, candidate->span_count, sizeof(LevelSpan));
+
+        if (layers_fit)
+        {
+            const uint32_t *row_starts = (const uint32_t*) (file.data() + candidate->tiles_offset);
+            const LevelSpan *spans = (const LevelSpan*) (file.data() + spans_offset);
+
+            // Every row's spans must be in range and inside the map
+            layers_fit = row_starts[0] == 0 && row_starts[row_count] == candidate->span_count;
+            for (size_t row = 0; row < row_count && layers_fit; row++)
+            {
+                if (row_starts[row] > row_starts[row + 1]) layers_fit = false;
+            }
+            for (uint32_t i = 0; i < candidate->span_count && layers_fit; i++)
+            {
+                if (spans[i].x + spans[i].length > candidate->width) layers_fit = false;
+            }
+        }
+    }
+
+    size_t cell_count = (size_t) candidate->width * candidate->height;
+
+    bool baked_fit = fits(file.size(), candidate->solid_offset, (cell_count + 31) / 32, sizeof(uint32_t))
+        && fits(file.size(), candidate->vertices_offset, candidate->vertex_count * 2, sizeof(float))
+        && fits(file.size(), candidate->texture_coordinates_offset, candidate->vertex_count * 2, sizeof(float))
+        && fits(file.size(), candidate->tile_cells_offset, candidate->vertex_count * 4, sizeof(float))
+        && fits(file.size(), candidate->chunks_offset, candidate->chunk_count, sizeof(LevelChunk))
+        && fits(file.size(), candidate->boxes_offset, candidate->box_count, sizeof(LevelBox));
+
+    if (baked_fit)
+    {
+        // Chunks are drawn and collided with straight from the file, so they must stay inside the arrays
+        const LevelChunk *candidate_chunks = (const LevelChunk*) (file.data() + candidate->chunks_offset);
+
+        for (uint32_t i = 0; i < candidate->chunk_count && baked_fit; i++)
+        {
+            const LevelChunk &chunk = candidate_chunks[i];
+            if (chunk.first_vertex < 0 || chunk.vertex_count < 0
+                || (uint32_t) chunk.first_vertex + (uint32_t) chunk.vertex_count > candidate->vertex_count) baked_fit = false;
+            if (chunk.first_box < 0 || chunk.box_count < 0
+                || (uint32_t) chunk.first_box + (uint32_t) chunk.box_count > candidate->box_count) baked_fit = false;
+        }
+    }
+
+    // A streaming index has to have regions to cover it with
+    bool regions_fit = candidate->region_count == 0
+        || (candidate->region_width > 0 && (size_t) candidate->region_count * candidate->region_width >= candidate->width);
+
+    if (!layers_fit || !baked_fit || !regions_fit
+        || !fits(file.size(), candidate->spawns_offset, candidate->spawn_count, sizeof(LevelSpawn))
+        || !fits(file.size(), candidate->properties_offset, candidate->property_count, sizeof(LevelProperty)))
+    {
+        LOG("Level " << filepath << " is damaged");
+        return;
+    }
+
+    this->header = candidate;
+    this->spawns = (const LevelSpawn*) (file.data() + candidate->spawns_offset);
+    this->properties = (const LevelProperty*) (file.data() + candidate->properties_offset);
+
+    this->solid = (const uint32_t*) (file.data() + candidate->solid_offset);
+    this->vertices = (const float*) (file.data() + candidate->vertices_offset);
+    this->texture_coordinates = (const float*) (file.data() + candidate->texture_coordinates_offset);
+    this->tile_cells = (const float*) (file.data() + candidate->tile_cells_offset);
+    this->chunks = (const LevelChunk*) (file.data() + candidate->chunks_offset);
+    this->boxes = (const LevelBox*) (file.data() + candidate->boxes_offset);
+}
+
+float const Level::get_property(const char *name, float fallback) const
+{
+    for (uint32_t i = 0; i < header->property_count; i++)
+    {
+        if (strncmp(properties[i].name, name, LEVEL_PROPERTY_NAME_SIZE) == 0) return properties[i].value;
+    }
+
+    return fallback;
+}
+
+// A rectangle of cells with the same key, in tiles from the top left of its chunk
+struct BakeRect
+{
+    int x, y;
+    int width, height;
+    int key;
+};
+
+// Greedy meshing over one chunk's keys (0 is empty): each rectangle starts at the first cell not yet
+// taken, grows right while the key holds, then down while every cell of the next row matches too.
+// Not always the fewest rectangles, but never more than one per run and usually far fewer.
+static void merge_cells(const int *keys, std::vector<BakeRect> &rects)
+{
+    bool taken[LEVEL_CHUNK_SIZE * LEVEL_CHUNK_SIZE] = {};
+
+    for (int y = 0; y < LEVEL_CHUNK_SIZE; y++)
+    {
+        for (int x = 0; x < LEVEL_CHUNK_SIZE; x++)
+        {
+            int key = keys[y * LEVEL_CHUNK_SIZE + x];
+            if (key == 0 || taken[y * LEVEL_CHUNK_SIZE + x]) continue;
+
+            BakeRect rect = { x, y, 1, 1, key };
+
+            while (rect.x + rect.width < LEVEL_CHUNK_SIZE
+                   && keys[y * LEVEL_CHUNK_SIZE + rect.x + rect.width] == key
+                   && !taken[y * LEVEL_CHUNK_SIZE + rect.x + rect.width]) rect.width++;
+
+            for (bool grows = true; grows && rect.y + rect.height < LEVEL_CHUNK_SIZE; )
+            {
+                int row = (rect.y + rect.height) * LEVEL_CHUNK_SIZE;
+                for (int i = rect.x; i < rect.x + rect.width && grows; i++)
+                {
+                    grows = keys[row + i] == key && !taken[row + i];
+                }
+                if (grows) rect.height++;
+            }
+
+            for (int j = rect.y; j < rect.y + rect.height; j++)
+            {
+                for (int i = rect.x; i < rect.x + rect.width; i++) taken[j * LEVEL_CHUNK_SIZE + i] = true;
+            }
+
+            rects.push_back(rect);
+        }
+    }
+}
+
+// Layer 0's runs, merged and turned into everything Map draws and collides with
+static void bake_geometry(LevelFileHeader &header, const std::vector<uint32_t> &row_starts, const std::vector<LevelSpan> &runs,
+                          std::vector<float> &vertices, std::vector<float> &texture_coordinates, std::vector<float> &tile_cells,
+                          std::vector<LevelChunk> &chunks, std::vector<LevelBox> &boxes)
+{
+    int width = header.width, height = header.height;
+    float tile_size = header.tile_size;
+    int tile_count_x = header.tileset_columns, tile_count_y = header.tileset_rows;
+
+    // Regions are baked where they sit in the world; chunks still start at the region's own left edge
+    int origin_x = header.origin_x;
+
+    int chunk_columns = (width + LEVEL_CHUNK_SIZE - 1) / LEVEL_CHUNK_SIZE;
+    const int CHUNK_CELLS = LEVEL_CHUNK_SIZE * LEVEL_CHUNK_SIZE;
+
+    // One band of chunks at a time: each chunk's tiles, and whether it has any
+    std::vector<int> band(chunk_columns * CHUNK_CELLS);
+    std::vector<bool> occupied(chunk_columns);
+    std::vector<BakeRect> rects;
+    int solid_keys[CHUNK_CELLS];
+
+    for (int chunk_y = 0; chunk_y < height; chunk_y += LEVEL_CHUNK_SIZE)
+    {
+        std::fill(band.begin(), band.end(), 0);
+        std::fill(occupied.begin(), occupied.end(), false);
+
+        for (int y = chunk_y; y < chunk_y + LEVEL_CHUNK_SIZE && y < height; y++)
+        {
+            for (uint32_t i = row_starts[y]; i < row_starts[y + 1]; i++)
+            {
+                for (int x = runs[i].x; x < runs[i].x + runs[i].length; x++)
+                {
+                    int column = x / LEVEL_CHUNK_SIZE;
+                    band[column * CHUNK_CELLS + (y - chunk_y) * LEVEL_CHUNK_SIZE + (x % LEVEL_CHUNK_SIZE)] = runs[i].tile;
+                    occupied[column] = true;
+                }
+            }
+        }
+
+        for (int column = 0; column < chunk_columns; column++)
+        {
+            if (!occupied[column]) continue;
+
+            int chunk_x = origin_x + column * LEVEL_CHUNK_SIZE;
+            const int *tiles = &band[column * CHUNK_CELLS];
+
+            LevelChunk chunk;
+            chunk.first_vertex = (int32_t) vertices.size() / 2;
+            chunk.first_box = (int32_t) boxes.size();
+
+            // Quads: one per rectangle of the same tile, its UVs counting tiles so the shader can wrap them
+            rects.clear();
+            merge_cells(tiles, rects);
+
+            for (size_t i = 0; i < rects.size(); i++)
+            {
+                const BakeRect &rect = rects[i];
+
+                float left   = (tile_size * (chunk_x + rect.x)) - (tile_size / 2);
+                float right  = (tile_size * (chunk_x + rect.x + rect.width)) - (tile_size / 2);
+                float top    = -(tile_size * (chunk_y + rect.y)) + (tile_size / 2);
+                float bottom = -(tile_size * (chunk_y + rect.y + rect.height)) + (tile_size / 2);
+
+                float repeat_x = (float) rect.width, repeat_y = (float) rect.height;
+
+                float u = (float) (rect.key % tile_count_x) / (float) tile_count_x;
+                float v = (float) (rect.key / tile_count_x) / (float) tile_count_y;
+
+                float tile_width = 1.0f / (float) tile_count_x;
+                float tile_height = 1.0f / (float) tile_count_y;
+
+                vertices.insert(vertices.end(), {
+                    left, top,
+                    left, bottom,
+                    right, bottom,
+                    left, top,
+                    right, bottom,
+                    right, top
+                });
+
+                texture_coordinates.insert(texture_coordinates.end(), {
+                    0.0f, 0.0f,
+                    0.0f, repeat_y,
+                    repeat_x, repeat_y,
+                    0.0f, 0.0f,
+                    repeat_x, repeat_y,
+                    repeat_x, 0.0f
+                });
+
+                for (int corner = 0; corner < 6; corner++) tile_cells.insert(tile_cells.end(), { u, v, tile_width, tile_height });
+            }
+
+            // Boxes: every non-empty tile is solid, whichever tile it is
+            for (int i = 0; i < CHUNK_CELLS; i++) solid_keys[i] = tiles[i] != 0 ? 1 : 0;
+
+            rects.clear();
+            merge_cells(solid_keys, rects);
+
+            for (size_t i = 0; i < rects.size(); i++)
+            {
+                const BakeRect &rect = rects[i];
+
+                LevelBox box;
+                box.min_x = (tile_size * (chunk_x + rect.x)) - (tile_size / 2);
+                box.max_x = (tile_size * (chunk_x + rect.x + rect.width)) - (tile_size / 2);
+                box.min_y = -(tile_size * (chunk_y + rect.y + rect.height)) + (tile_size / 2);
+                box.max_y = -(tile_size * (chunk_y + rect.y)) + (tile_size / 2);
+
+                boxes.push_back(box);
+            }
+
+            chunk.vertex_count = (int32_t) vertices.size() / 2 - chunk.first_vertex;
+            chunk.box_count = (int32_t) boxes.size() - chunk.first_box;
+
+            int last_x = std::min(chunk_x + LEVEL_CHUNK_SIZE, origin_x + width);
+            int last_y = std::min(chunk_y + LEVEL_CHUNK_SIZE, height);
+
+            chunk.min_x = (tile_size * chunk_x) - (tile_size / 2);
+            chunk.min_y = -(tile_size * last_y) + (tile_size / 2);
+            chunk.max_x = (tile_size * last_x) - (tile_size / 2);
+            chunk.max_y = -(tile_size * chunk_y) + (tile_size / 2);
+
+            chunks.push_back(chunk);
+        }
+    }
+
+    header.left_bound   = (tile_size * origin_x) - (tile_size / 2);
+    header.right_bound  = (tile_size * (origin_x + width)) - (tile_size / 2);
+    header.top_bound    = 0 + (tile_size / 2);
+    header.bottom_bound = -(tile_size * height) + (tile_size / 2);
+}
+
+static void pad_to_four(std::vector<unsigned char> &bytes)
+{
+    while (bytes.size() % 4 != 0) bytes.push_back(0);
+}
+
+static void append(std::vector<unsigned char> &bytes, const void *data, size_t size)
+{
+    bytes.insert(bytes.end(), (const unsigned char*) data, (const unsigned char*) data + size);
+}
+
+// What a level source says, before it is written out whole or cut into regions
+struct LevelSource
+{
+    int width = 0, height = 0;
+    int tileset_columns = 0, tileset_rows = 0;
+    float tile_size = 1.0f;
+    int region_width = 0;       // 0: not streamed
+    std::vector<int> tiles;
+    std::vector<LevelSpawn> spawns;
+    std::vector<LevelProperty> properties;
+};
+
+// Writes one level file: a whole level, a streaming index (region_count > 0) or one region (at origin_x)
+static bool write_level(const char *output_path, const LevelSource &level, int region_count, int origin_x)
+{
+    int width = level.width, height = level.height;
+    const std::vector<int> &tiles = level.tiles;
+    const std::vector<LevelSpawn> &spawns = level.spawns;
+    const std::vector<LevelProperty> &properties = level.properties;
+
+    // Tiles get the smallest type that holds every index used
+    int largest = 0;
+    for (size_t i = 0; i < tiles.size(); i++) if (tiles[i] > largest) largest = tiles[i];
+
+    // Runs of one tile along each row, empty cells left out
+    std::vector<uint32_t> row_starts;
+    std::vector<LevelSpan> runs;
+
+    for (int y = 0; y < height; y++)
+    {
+        row_starts.push_back((uint32_t) runs.size());
+
+        for (int x = 0; x < width; )
+        {
+            int tile = tiles[y * width + x];
+            int length = 1;
+            while (x + length < width && tiles[y * width + x + length] == tile) length++;
+
+            if (tile != 0)
+            {
+                LevelSpan span = { (uint16_t) x, (uint16_t) length, (uint16_t) tile, 0 };
+                runs.push_back(span);
+            }
+            x += length;
+        }
+    }
+    row_starts.push_back((uint32_t) runs.size());
+
+    LevelFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LEVEL_FILE_MAGIC, sizeof(header.magic));
+    header.version = LEVEL_FILE_VERSION;
+    header.width = (uint16_t) width;
+    header.height = (uint16_t) height;
+    header.layer_count = 1;
+    header.tile_bytes = largest <= UINT8_MAX ? 1 : 2;
+
+    // Whichever is smaller: mostly-empty levels cost what's in them, mostly-full ones don't pay for span headers
+    size_t dense_size = (size_t) width * height * header.tile_bytes;
+    size_t spans_size = row_starts.size() * sizeof(uint32_t) + runs.size() * sizeof(LevelSpan);
+
+    header.layer_encoding = spans_size < dense_size ? LAYER_SPANS : LAYER_DENSE;
+    header.span_count = header.layer_encoding == LAYER_SPANS ? (uint32_t) runs.size() : 0;
+
+    header.tile_size = level.tile_size;
+    header.tileset_columns = (uint16_t) level.tileset_columns;
+    header.tileset_rows = (uint16_t) level.tileset_rows;
+
+    header.region_count = (uint32_t) region_count;
+    header.region_width = (uint16_t) level.region_width;
+    header.origin_x = (uint16_t) origin_x;
+
+    std::vector<uint32_t> solid(((size_t) width * height + 31) / 32, 0);
+    for (size_t cell = 0; cell < tiles.size(); cell++)
+    {
+        if (tiles[cell] != 0) solid[cell / 32] |= 1u << (cell % 32);
+    }
+
+    std::vector<float> vertices, texture_coordinates, tile_cells;
+    std::vector<LevelChunk> chunks;
+    std::vector<LevelBox> boxes;
+    bake_geometry(header, row_starts, runs, vertices, texture_coordinates, tile_cells, chunks, boxes);
+
+    header.vertex_count = (uint32_t) vertices.size() / 2;
+    header.chunk_count = (uint32_t) chunks.size();
+    header.box_count = (uint32_t) boxes.size();
+    header.spawn_count = (uint32_t) spawns.size();
+    header.property_count = (uint32_t) properties.size();
+
+    std::vector<unsigned char> bytes(sizeof(header));
+
+    header.tiles_offset = (uint32_t) bytes.size();
+    if (header.layer_encoding == LAYER_SPANS)
+    {
+        append(bytes, row_starts.data(), row_starts.size() * sizeof(uint32_t));
+        if (!runs.empty()) append(bytes, runs.data(), runs.size() * sizeof(LevelSpan));
+    }
+    else
+    {
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            if (header.tile_bytes == 1) bytes.push_back((unsigned char) tiles[i]);
+            else { uint16_t tile = (uint16_t) tiles[i]; append(bytes, &tile, sizeof(tile)); }
+        }
+    }
+    pad_to_four(bytes);
+
+    header.spawns_offset = (uint32_t) bytes.size();
+    if (!spawns.empty()) append(bytes, spawns.data(), spawns.size() * sizeof(LevelSpawn));
+
+    header.properties_offset = (uint32_t) bytes.size();
+    if (!properties.empty()) append(bytes, properties.data(), properties.size() * sizeof(LevelProperty));
+
+    header.solid_offset = (uint32_t) bytes.size();
+    append(bytes, solid.data(), solid.size() * sizeof(uint32_t));
+
+    header.vertices_offset = (uint32_t) bytes.size();
+    if (!vertices.empty()) append(bytes, vertices.data(), vertices.size() * sizeof(float));
+
+    header.texture_coordinates_offset = (uint32_t) bytes.size();
+    if (!texture_coordinates.empty()) append(bytes, texture_coordinates.data(), texture_coordinates.size() * sizeof(float));
+
+    header.tile_cells_offset = (uint32_t) bytes.size();
+    if (!tile_cells.empty()) append(bytes, tile_cells.data(), tile_cells.size() * sizeof(float));
+
+    header.chunks_offset = (uint32_t) bytes.size();
+    if (!chunks.empty()) append(bytes, chunks.data(), chunks.size() * sizeof(LevelChunk));
+
+    header.boxes_offset = (uint32_t) bytes.size();
+    if (!boxes.empty()) append(bytes, boxes.data(), boxes.size() * sizeof(LevelBox));
+
+    memcpy(bytes.data(), &header, sizeof(header));
+
+    std::ofstream output(output_path, std::ios::binary);
+    output.write((const char*) bytes.data(), bytes.size());
+
+    if (output.fail())
+    {
+        LOG("Unable to write level " << output_path);
+        return false;
+    }
+
+    LOG(output_path << ": " << width << "x" << height << ", "
+        << (region_count > 0 ? std::to_string(region_count) + " regions, " : std::string())
+        << (header.layer_encoding == LAYER_SPANS ? std::to_string(runs.size()) + " spans, " : std::to_string(header.tile_bytes) + " byte tiles, ")
+        << spawns.size() << " spawns, " << properties.size() << " properties, " << header.vertex_count << " vertices, " << header.box_count << " boxes, " << bytes.size() << " bytes");
+    return true;
+}
+
+bool Level::build(const char *source_path, const char *output_path)
+{
+    std::ifstream source(source_path);
+    if (source.fail())
+    {
+        LOG("Unable to read level source " << source_path);
+        return false;
+    }
+
+    LevelSource level;
+    int &width = level.width, &height = level.height;
+    int &tileset_columns = level.tileset_columns, &tileset_rows = level.tileset_rows;
+    float &tile_size = level.tile_size;
+    int &region_width = level.region_width;
+    std::vector<int> &tiles = level.tiles;
+    std::vector<LevelSpawn> &spawns = level.spawns;
+    std::vector<LevelProperty> &properties = level.properties;
+
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(source, line))
+    {
+        line_number++;
+
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword) || keyword[0] == '#') continue;
+
+        if (keyword == "size")
+        {
+            words >> width >> height;
+            if (width <= 0 || height <= 0 || width > UINT16_MAX || height > UINT16_MAX) { LOG(source_path << ":" << line_number << ": bad size"); return false; }
+        }
+        else if (keyword == "tileset")
+        {
+            words >> tileset_columns >> tileset_rows;
+            if (tileset_columns <= 0 || tileset_rows <= 0 || tileset_columns > UINT16_MAX || tileset_rows > UINT16_MAX) { LOG(source_path << ":" << line_number << ": bad tileset"); return false; }
+        }
+        else if (keyword == "tile_size")
+        {
+            words >> tile_size;
+            if (words.fail() || tile_size <= 0.0f) { LOG(source_path << ":" << line_number << ": bad tile_size"); return false; }
+        }
+        else if (keyword == "region_width")
+        {
+            words >> region_width;
+            if (words.fail() || region_width <= 0 || region_width > UINT16_MAX) { LOG(source_path << ":" << line_number << ": bad region_width"); return false; }
+        }
+        else if (keyword == "property")
+        {
+            LevelProperty property;
+            memset(&property, 0, sizeof(property));
+
+            std::string name;
+            words >> name >> property.value;
+            if (words.fail() || name.size() >= LEVEL_PROPERTY_NAME_SIZE) { LOG(source_path << ":" << line_number << ": bad property"); return false; }
+
+            memcpy(property.name, name.data(), name.size());
+            properties.push_back(property);
+        }
+        else if (keyword == "spawn")
+        {
+            LevelSpawn spawn;
+            memset(&spawn, 0, sizeof(spawn));
+
+            std::string type;
+            int variant = 0;
+            words >> type >> variant >> spawn.x >> spawn.y;
+            if (words.fail()) { LOG(source_path << ":" << line_number << ": bad spawn"); return false; }
+
+            // The values are optional; missing ones stay 0
+            words >> spawn.values[0] >> spawn.values[1];
+
+            if (type == "player")     spawn.type = SPAWN_PLAYER;
+            else if (type == "enemy") spawn.type = SPAWN_ENEMY;
+            else if (type == "light") spawn.type = SPAWN_LIGHT;
+            else { LOG(source_path << ":" << line_number << ": unknown spawn type " << type); return false; }
+
+            spawn.variant = (uint16_t) variant;
+            spawns.push_back(spawn);
+        }
+        else if (keyword == "tiles")
+        {
+            // The rest of the file is the grid, row by row from the top
+            if (width == 0 || tileset_columns == 0) { LOG(source_path << ":" << line_number << ": tiles before size and tileset"); return false; }
+
+            // Every tile has to be a cell of the tileset, or it would be drawn from outside the texture
+            int tile;
+            while (source >> tile)
+            {
+                if (tile < 0 || tile >= tileset_columns * tileset_rows)
+                {
+                    LOG(source_path << ": tile " << tile << " at (" << tiles.size() % width << ", " << tiles.size() / width << ") is not in the "
+                        << tileset_columns << "x" << tileset_rows << " tileset");
+                    return false;
+                }
+                tiles.push_back(tile);
+            }
+            break;
+        }
+        else
+        {
+            LOG(source_path << ":" << line_number << ": unknown keyword " << keyword);
+            return false;
+        }
+    }
+
+    if (tiles.size() != (size_t) width * height)
+    {
+        LOG(source_path << ": expected " << width * height << " tiles, found " << tiles.size());
+        return false;
+    }
+
+    if (region_width == 0 || region_width >= width) return write_level(output_path, level, 0, 0);
+
+    // Streamed: an index holding what belongs to the whole world, then one level per region_width columns
+    int region_count = (width + region_width - 1) / region_width;
+
+    LevelSource index = level;
+    index.tiles.assign(tiles.size(), 0);
+    index.spawns.clear();
+
+    std::vector<LevelSource> regions(region_count);
+
+    for (int i = 0; i < region_count; i++)
+    {
+        LevelSource &region = regions[i];
+        region.width = std::min(region_width, width - i * region_width);
+        region.height = height;
+        region.tileset_columns = tileset_columns;
+        region.tileset_rows = tileset_rows;
+        region.tile_size = tile_size;
+        region.region_width = region_width;
+
+        for (int y = 0; y < height; y++)
+        {
+            const int *row = &tiles[(size_t) y * width + i * region_width];
+            region.tiles.insert(region.tiles.end(), row, row + region.width);
+        }
+    }
+
+    // The player belongs to the world; everything else to the region whose column it starts in
+    for (size_t i = 0; i < spawns.size(); i++)
+    {
+        if (spawns[i].type == SPAWN_PLAYER) { index.spawns.push_back(spawns[i]); continue; }
+
+        int column = (int) floor((spawns[i].x + (tile_size / 2)) / tile_size);
+        column = std::max(0, std::min(column, width - 1));
+        regions[column / region_width].spawns.push_back(spawns[i]);
+    }
+
+    if (!write_level(output_path, index, region_count, 0)) return false;
+
+    for (int i = 0; i < region_count; i++)
+    {
+        if (!write_level(region_path(output_path, i).c_str(), regions[i], 0, i * region_width)) return false;
+    }
+
+    return true;
+}
+
+std::string Level::region_path(const char *index_path, int region)
+{
+    std::string path = index_path;
+    std::string extension;
+
+    size_t dot = path.rfind('.');
+    if (dot != std::string::npos && path.find_first_of("/\\", dot) == std::string::npos)
+    {
+        extension = path.substr(dot);
+        path.resize(dot);
+    }
+
+    return path + "_" + std::to_string(region) + extension;
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include "MappedFile.h"
+
+// Levels on disk: a header, then the tile layers, the spawn table and the properties, each found by
+// its offset from the start of the file. Everything is little-endian and 4-byte aligned so that a
+// mapped file can be used in place. Levels are written by Level::build from a text source; see levels/.
+//
+// Layers are stored one of two ways, whichever is smaller for the level:
+//   LAYER_DENSE  every cell, row by row from the top, as uint8 or uint16 (tile_bytes)
+//   LAYER_SPANS  only the non-empty runs: uint32 row_starts[layer_count * height + 1], then LevelSpan[span_count].
+//                Row r's runs are spans[row_starts[r]] up to spans[row_starts[r + 1]], left to right.
+//
+// Everything Map needs is baked in as well, so making a map from a level is a handful of pointers:
+// a solid bitset for collision, the bounds, and the vertex and UV arrays cut into render chunks.
+// The game reads nothing else of the tiles; loading only checks that the layers are sound.
+// Within each chunk, runs of identical tiles are merged greedily into single quads whose texture
+// coordinates count in tiles, and solid tiles into collision boxes; see merge_cells in Level.cpp.
+//
+// A source with a region_width is cut into regions for streaming: the file named is then only an
+// index (full size, player spawn, properties, no tiles), and region i is a level of its own at
+// region_path(index, i), holding columns from origin_x = i * region_width with its geometry baked
+// where it sits in the world, and the spawns that fall in those columns.
+enum LevelLayerEncoding
+{
+    LAYER_DENSE,
+    LAYER_SPANS
+};
+
+struct LevelFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint16_t width, height;     // In tiles
+    uint16_t layer_count;
+    uint16_t tile_bytes;        // LAYER_DENSE only: 1 for uint8 tiles, 2 for uint16
+    uint16_t layer_encoding;
+    uint16_t reserved;
+    uint32_t span_count;        // LAYER_SPANS only
+    uint32_t spawn_count;
+    uint32_t property_count;
+    uint32_t tiles_offset;      // Layers one after the other, each row by row from the top
+    uint32_t spawns_offset;
+    uint32_t properties_offset;
+
+    // Baked from layer 0
+    float tile_size;            // World units per tile
+    uint16_t tileset_columns, tileset_rows;
+    float left_bound, right_bound, top_bound, bottom_bound;
+    uint32_t solid_offset;      // One bit per cell, row by row from the top, 32 cells to a uint32
+    uint32_t vertex_count;      // Each two floats in the first two arrays, four in the tile cells
+    uint32_t vertices_offset;
+    uint32_t texture_coordinates_offset;
+    uint32_t tile_cells_offset;
+    uint32_t chunk_count;
+    uint32_t chunks_offset;
+    uint32_t box_count;
+    uint32_t boxes_offset;
+
+    uint32_t region_count;      // Streaming indexes only
+    uint16_t region_width;      // In tiles
+    uint16_t origin_x;          // Regions only: the first world column they hold
+};
+
+const char LEVEL_FILE_MAGIC[4] = { 'M', 'R', 'L', 'V' };
+const uint32_t LEVEL_FILE_VERSION = 5;
+
+// Tiles per side of a render chunk; lights are picked per chunk rather than for the whole map
+#define LEVEL_CHUNK_SIZE 8
+
+// A contiguous range of the baked vertices and boxes, all inside min..max
+struct LevelChunk
+{
+    int32_t first_vertex;
+    int32_t vertex_count;
+    int32_t first_box;
+    int32_t box_count;
+    float min_x, min_y;
+    float max_x, max_y;
+};
+
+// Solid tiles merged into one rectangle, in world units
+struct LevelBox
+{
+    float min_x, min_y;
+    float max_x, max_y;
+};
+
+// Length copies of one tile, starting at x
+struct LevelSpan
+{
+    uint16_t x, length;
+    uint16_t tile;
+    uint16_t reserved;
+};
+
+enum LevelSpawnType
+{
+    SPAWN_PLAYER,
+    SPAWN_ENEMY,    // values: width, height
+    SPAWN_LIGHT     // values: radius, intensity
+};
+
+// Somewhere a scene should put something when it starts; what variant means is up to the scene
+struct LevelSpawn
+{
+    uint16_t type;
+    uint16_t variant;
+    float x, y;                 // World units
+    float values[2];
+};
+
+#define LEVEL_PROPERTY_NAME_SIZE 28
+
+struct LevelProperty
+{
+    char name[LEVEL_PROPERTY_NAME_SIZE];
+    float value;
+};
+
+class Level {
+    MappedFile file;
+    std::string path;
+
+    const LevelFileHeader *header = nullptr;
+    const LevelSpawn *spawns = nullptr;
+    const LevelProperty *properties = nullptr;
+
+    const uint32_t *solid = nullptr;
+    const float *vertices = nullptr;
+    const float *texture_coordinates = nullptr;
+    const float *tile_cells = nullptr;
+    const LevelChunk *chunks = nullptr;
+    const LevelBox *boxes = nullptr;
+
+public:
+    Level(const char *filepath);
+
+    // False if the file is missing, truncated or from another version
+    bool const is_valid() const { return header != nullptr; };
+
+    const char *get_path() const { return path.c_str(); };
+
+    // Reads the whole file in now rather than a page at a time on first use
+    void touch() const { file.touch(); };
+
+    int const get_width()  const { return header->width;  };
+    int const get_height() const { return header->height; };
+    int const get_layer_count() const { return header->layer_count; };
+
+    int const get_spawn_count() const { return (int) header->spawn_count; };
+    const LevelSpawn &get_spawn(int index) const { return spawns[index]; };
+
+    float const get_property(const char *name, float fallback) const;
+
+    // Baked geometry; see LevelFileHeader
+    const LevelFileHeader &get_header() const { return *header; };
+
+    bool const is_solid(int x, int y) const { size_t cell = (size_t) y * header->width + x; return (solid[cell / 32] >> (cell % 32)) & 1; };
+
+    const float *get_vertices() const            { return vertices;            };
+    const float *get_texture_coordinates() const { return texture_coordinates; };
+    const float *get_tile_cells() const          { return tile_cells;          };
+    const LevelChunk *get_chunks() const         { return chunks;              };
+    const LevelBox *get_boxes() const            { return boxes;               };
+
+    // What the baked geometry above takes up: two, two and four floats a vertex, then chunks and boxes
+    size_t const get_geometry_bytes() const
+    {
+        return (size_t) header->vertex_count * 8 * sizeof(float) + header->chunk_count * sizeof(LevelChunk) + header->box_count * sizeof(LevelBox);
+    };
+
+    // Compiles a text level (see levels/world.txt) into the binary format, cutting it into regions if it
+    // asks to be streamed; false, after saying why, on any error
+    static bool build(const char *source_path, const char *output_path);
+
+    // Where region i of a streamed level lives: levels/world.lvl's regions are levels/world_<i>.lvl
+    static std::string region_path(const char *index_path, int region);
+};
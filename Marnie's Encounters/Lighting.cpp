@@ -0,0 +1,67 @@
+#include "Lighting.h"
+#include "glm/gtc/matrix_inverse.hpp"
+
+Lighting::Lighting()
+{
+    view_min = glm::vec2(0.0f);
+    view_max = glm::vec2(0.0f);
+}
+
+bool const Lighting::touches(const Light &light, glm::vec2 min, glm::vec2 max)
+{
+    // Closest point of the rectangle to the light, then a circle test against it
+    glm::vec2 closest = glm::clamp(light.position, min, max);
+    glm::vec2 offset = light.position - closest;
+
+    return glm::dot(offset, offset) < light.radius * light.radius;
+}
+
+void Lighting::cull(glm::mat4 view_matrix, glm::mat4 projection_matrix)
+{
+    // Un-project the corners of clip space to find what part of the world is on screen
+    glm::mat4 inverse = glm::inverse(projection_matrix * view_matrix);
+    glm::vec4 corner_a = inverse * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
+    glm::vec4 corner_b = inverse * glm::vec4( 1.0f,  1.0f, 0.0f, 1.0f);
+
+    view_min = glm::min(glm::vec2(corner_a), glm::vec2(corner_b));
+    view_max = glm::max(glm::vec2(corner_a), glm::vec2(corner_b));
+
+    visible_lights.clear();
+
+    // Static lights are already in the lightmap, so only the dynamic ones are considered
+    for (size_t i = 0; i < dynamic_lights.size(); i++) {
+        if (touches(dynamic_lights[i], view_min, view_max)) visible_lights.push_back(dynamic_lights[i]);
+    }
+}
+
+float const Lighting::brightness(const Light &light, glm::vec2 position)
+{
+    float dist = glm::distance(light.position, position);
+    float attenuation = 1.0f / (1.0f + dist);
+    float falloff = 1.0f - glm::smoothstep(light.radius * 0.75f, light.radius, dist);
+
+    return light.intensity * attenuation * falloff;
+}
+
+bool const Lighting::is_visible(glm::vec2 min, glm::vec2 max) const
+{
+    return min.x < view_max.x && max.x > view_min.x && min.y < view_max.y && max.y > view_min.y;
+}
+
+void Lighting::upload(ShaderProgram *program, glm::vec2 min, glm::vec2 max)
+{
+    int count = 0;
+
+    for (size_t i = 0; i < visible_lights.size() && count < MAX_LIGHTS; i++) {
+        const Light &light = visible_lights[i];
+        if (!touches(light, min, max)) continue;
+
+        positions[count * 2]     = light.position.x;
+        positions[count * 2 + 1] = light.position.y;
+        radii[count]             = light.radius;
+        intensities[count]       = light.intensity;
+        count++;
+    }
+
+    program->SetLights(count, positions, radii, intensities);
+}
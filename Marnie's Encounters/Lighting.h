@@ -0,0 +1,69 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+
+// Also sizes the light arrays in shaders/fragment_lit.glsl, which is built with it defined (see main.cpp)
+#define MAX_LIGHTS 16
+
+struct Light
+{
+    glm::vec2 position;
+    float radius;      // Past this distance the light contributes nothing
+    float intensity;
+};
+
+class Lighting {
+private:
+    // Static lights live as long as the scene (torches) and are baked into the map's lightmap;
+    // dynamic lights are rebuilt every frame and are the only ones the shader evaluates
+    std::vector<Light> static_lights;
+    std::vector<Light> dynamic_lights;
+
+    // Lights touching the screen this frame; every per-draw selection starts from here
+    std::vector<Light> visible_lights;
+
+    glm::vec2 view_min, view_max;
+
+    // Scratch space for the uniform upload, so that selecting lights never allocates
+    float positions[MAX_LIGHTS * 2];
+    float radii[MAX_LIGHTS];
+    float intensities[MAX_LIGHTS];
+
+    static bool const touches(const Light &light, glm::vec2 min, glm::vec2 max);
+
+public:
+    Lighting();
+
+    void clear_static_lights()            { static_lights.clear();  };
+    void clear_dynamic_lights()           { dynamic_lights.clear(); };
+    void add_static_light(Light light)    { static_lights.push_back(light);  };
+    void add_dynamic_light(Light light)   { dynamic_lights.push_back(light); };
+
+    // Works out the visible world rectangle and keeps only the lights that reach it
+    void cull(glm::mat4 view_matrix, glm::mat4 projection_matrix);
+
+    bool const is_visible(glm::vec2 min, glm::vec2 max) const;
+    glm::vec2 const get_view_center() const { return (view_min + view_max) * 0.5f; };
+
+    // Uploads the (at most MAX_LIGHTS) visible lights that reach the given rectangle
+    void upload(ShaderProgram *program, glm::vec2 min, glm::vec2 max);
+    void upload_visible(ShaderProgram *program) { upload(program, view_min, view_max); };
+
+    int const get_visible_light_count() const { return (int) visible_lights.size(); };
+    std::vector<Light> const &get_static_lights() const { return static_lights; };
+    std::vector<Light> const &get_dynamic_lights() const { return dynamic_lights; };
+
+    // Same falloff as fragment_lit.glsl, so baked and live lights look alike
+    static float const brightness(const Light &light, glm::vec2 position);
+};
@@ -1,85 +1,376 @@
+#define LOG(argument) std::cout << argument << '\n'
+
 #include "Map.h"
+#include "Lighting.h"
+#include "Resources.h"
+#include "RegionLoader.h"
+#include "Snapshot.h"
+#include "Counters.h"
+#include "Allocations.h"
+#include <algorithm>
+#include <iostream>
+#include <assert.h>
+
+MapRegion::~MapRegion()
+{
+    GLuint texture_id = this->lightmap_texture_id;
+    if (texture_id != 0) this->resources->release_texture(texture_id);
+}
 
-Map::Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y)
+Map::Map(Level *level, GLuint texture_id, Resources *resources)
 {
-    this->width = width;
-    this->height = height;
+    // The level has already said what was wrong with it
+    assert(level->is_valid());
+    
+    // Everything was baked when the level was built; nothing here touches a tile
+    const LevelFileHeader &header = level->get_header();
+    
+    this->level.reset(level);
+    this->width = header.width;
+    this->height = header.height;
     
-    this->level_data = level_data;
     this->texture_id = texture_id;
+    this->resources = resources;
+    
+    this->tile_size = header.tile_size;
+    this->tile_count_x = header.tileset_columns;
+    this->tile_count_y = header.tileset_rows;
+    
+    this->left_bound   = header.left_bound;
+    this->right_bound  = header.right_bound;
+    this->top_bound    = header.top_bound;
+    this->bottom_bound = header.bottom_bound;
+    
+    if (header.region_count == 0)
+    {
+        // Not streamed: the level is its own only region
+        this->region_width = this->width;
+        this->regions.resize(1);
+    
+        std::shared_ptr<MapRegion> region = std::make_shared<MapRegion>();
+        region->level = this->level;
+        region->active = true;
+        region->needs_lightmap = true;
+    
+        this->regions[0] = region;
+        this->open_regions.push_back(0);
+        return;
+    }
+    
+    this->region_width = header.region_width;
+    this->regions.resize(header.region_count);
+    this->broken_regions.resize(header.region_count, false);
+    this->loader = new RegionLoader(level->get_path());
+}
+
+Map::~Map()
+{
+    // Stops the loader before anything it might hand over is gone
+    delete this->loader;
+    
+    // Regions give back their own lightmaps, whenever the last frame drawing them is done
+    for (size_t i = 0; i < this->spare_lightmaps.size(); i++) this->resources->release_texture(this->spare_lightmaps[i]);
+}
+
+void Map::open_region(int index, Level *region_level)
+{
+    // Regions are built with their index, so anything else is a stale or mismatched file
+    if (!region_level->is_valid()
+        || region_level->get_header().origin_x != index * this->region_width
+        || region_level->get_width() > this->region_width
+        || region_level->get_height() != this->height
+        || region_level->get_header().tile_size != this->tile_size)
+    {
+        LOG("Region " << index << " of " << this->level->get_path() << " doesn't belong to it; rebuild it with --build-level");
+        assert(false);
     
-    this->tile_size = tile_size;
-    this->tile_count_x = tile_count_x;
-    this->tile_count_y = tile_count_y;
+        // Left closed for good, rather than asked for again every step
+        delete region_level;
+        this->broken_regions[index] = true;
+        return;
+    }
     
-    this->build();
+    // Also reached when the loader finishes, which may be long after the focus moved
+    ALLOC_WARM_UP();
+    
+    std::shared_ptr<MapRegion> region = std::make_shared<MapRegion>();
+    region->level.reset(region_level);
+    
+    this->regions[index] = region;
+    this->open_regions.push_back(index);
 }
 
-void Map::build()
+void Map::close_region(int index)
 {
-    for(int y = 0; y < this->height; y++)
+    // Its lightmap can be reused straight away: closed regions are well off screen, so any frame still holding one culls it.
+    // Taking it out of the region means the region won't give it back when that frame lets go.
+    GLuint lightmap_texture_id = this->regions[index]->lightmap_texture_id.exchange(0);
+    if (lightmap_texture_id != 0) this->spare_lightmaps.push_back(lightmap_texture_id);
+    
+    this->regions[index].reset();
+    this->open_regions.erase(std::find(this->open_regions.begin(), this->open_regions.end(), index));
+}
+
+void Map::stream(glm::vec3 focus, const Lighting *lighting)
+{
+    PROFILE_ZONE("Map::stream");
+    
+    if (this->loader != nullptr)
+    {
+        int focus_tile = (int) floor((focus.x + (this->tile_size / 2)) / this->tile_size);
+        int region_count = (int) this->regions.size();
+        int previous_focus = this->focus_region;
+        this->focus_region = std::max(0, std::min(focus_tile / this->region_width, region_count - 1));
+    
+        // Moving into another region requests, opens, activates, lights and closes regions, all of which allocate
+        if (this->focus_region != previous_focus) ALLOC_WARM_UP();
+    
+        // Whatever the loader finished, if it's still wanted; it doesn't become active by being open
+        int index;
+        Level *region_level;
+        while (this->loader->take_any(&index, &region_level))
+        {
+            if (this->regions[index] == nullptr && abs(index - this->focus_region) <= REGION_EVICT_RADIUS) open_region(index, region_level);
+            else delete region_level;
+        }
+    
+        for (size_t i = this->open_regions.size(); i-- > 0; )
+        {
+            int open = this->open_regions[i];
+            MapRegion *region = this->regions[open].get();
+            int distance = abs(open - this->focus_region);
+    
+            if (distance > REGION_PREFETCH_RADIUS) region->active = false;
+            if (distance > REGION_EVICT_RADIUS) close_region(open);
+        }
+    
+        int first = std::max(0, this->focus_region - REGION_PREFETCH_RADIUS);
+        int last = std::min(region_count - 1, this->focus_region + REGION_PREFETCH_RADIUS);
+    
+        for (int i = first; i <= last; i++)
+        {
+            if (this->broken_regions[i]) continue;
+    
+            if (abs(i - this->focus_region) > REGION_ACTIVE_RADIUS)
+            {
+                if (this->regions[i] == nullptr) this->loader->request(i);
+                continue;
+            }
+    
+            // Needed now: if the loader hasn't got to it, open it here rather than wait
+            if (this->regions[i] == nullptr)
+            {
+                Level *taken = this->loader->take(i);
+                if (taken == nullptr)
+                {
+                    PROFILE_ZONE("open region");
+                    taken = new Level(Level::region_path(this->level->get_path(), i).c_str());
+                }
+                open_region(i, taken);
+            }
+    
+            MapRegion *region = this->regions[i].get();
+            if (region == nullptr || region->active) continue;
+    
+            // Its lights reach into its neighbours, so theirs need baking again too
+            region->active = true;
+            region->needs_lightmap = true;
+            if (i > 0 && is_region_active(i - 1)) this->regions[i - 1]->needs_lightmap = true;
+            if (i + 1 < region_count && is_region_active(i + 1)) this->regions[i + 1]->needs_lightmap = true;
+        }
+    }
+    
+    for (size_t i = 0; i < this->open_regions.size(); i++)
+    {
+        int open = this->open_regions[i];
+        if (this->regions[open]->active && this->regions[open]->needs_lightmap) bake_lightmap(open, lighting);
+    }
+}
+
+void Map::bake_lightmap(int index, const Lighting *lighting)
+{
+    PROFILE_ZONE("Map::bake_lightmap");
+    
+    MapRegion *region = this->regions[index].get();
+    region->needs_lightmap = false;
+    
+    // The scene's own static lights, and the light spawns of this region and the active ones either side
+    std::vector<Light> lights = lighting->get_static_lights();
+    
+    for (int neighbour = std::max(0, index - 1); neighbour <= std::min((int) this->regions.size() - 1, index + 1); neighbour++)
+    {
+        if (!is_region_active(neighbour)) continue;
+    
+        const Level *neighbour_level = this->regions[neighbour]->level.get();
+        for (int i = 0; i < neighbour_level->get_spawn_count(); i++)
+        {
+            const LevelSpawn &spawn = neighbour_level->get_spawn(i);
+            if (spawn.type != SPAWN_LIGHT) continue;
+    
+            Light light;
+            light.position  = glm::vec2(spawn.x, spawn.y);
+            light.radius    = spawn.values[0];
+            light.intensity = spawn.values[1];
+            lights.push_back(light);
+        }
+    }
+    
+    if (lights.empty()) return;
+    
+    const LevelFileHeader &header = region->level->get_header();
+    
+    int lightmap_width  = header.width  * LIGHTMAP_TEXELS_PER_TILE;
+    int lightmap_height = header.height * LIGHTMAP_TEXELS_PER_TILE;
+    
+    glm::vec2 origin = glm::vec2(header.left_bound, header.bottom_bound);
+    float texel_size = this->tile_size / LIGHTMAP_TEXELS_PER_TILE;
+    
+    // Row 0 is the bottom of the region, matching the UVs fragment_lit.glsl derives from world space
+    std::vector<unsigned char> texels(lightmap_width * lightmap_height);
+    
+    for (int y = 0; y < lightmap_height; y++)
     {
-        for(int x = 0; x < this->width; x++) {
-            int tile = this->level_data[y * this->width + x];
-            
-            if (tile == 0) continue;
-            
-            float u = (float) (tile % this->tile_count_x) / (float) this->tile_count_x;
-            float v = (float) (tile / this->tile_count_x) / (float) this->tile_count_y;
-            
-            float tile_width = 1.0f/ (float) this->tile_count_x;
-            float tile_height = 1.0f/ (float) this->tile_count_y;
-            
-            float x_offset = -(this->tile_size / 2); // From center of tile
-            float y_offset = (this->tile_size / 2); // From center of tile
-            
-            this->vertices.insert(vertices.end(), {
-                x_offset + (this->tile_size * x), y_offset + -this->tile_size * y,
-                x_offset + (this->tile_size * x), y_offset + (-this->tile_size * y) - this->tile_size,
-                x_offset + (this->tile_size * x) + this->tile_size, y_offset + (-this->tile_size * y) - this->tile_size,
-                x_offset + (this->tile_size * x), y_offset + -this->tile_size * y,
-                x_offset + (this->tile_size * x) + this->tile_size, y_offset + (-this->tile_size * y) - tile_size,
-                x_offset + (this->tile_size * x) + this->tile_size, y_offset + -this->tile_size * y
-            });
-            
-            this->texture_coordinates.insert(texture_coordinates.end(), {
-                u, v,
-                u, v + (tile_height),
-                u + tile_width, v + (tile_height),
-                u, v,
-                u + tile_width, v + (tile_height),
-                u + tile_width, v
-            });
+        for (int x = 0; x < lightmap_width; x++)
+        {
+            glm::vec2 position = origin + (glm::vec2(x, y) + 0.5f) * texel_size;
+    
+            float brightness = 0.0f;
+            for (size_t i = 0; i < lights.size(); i++) brightness += Lighting::brightness(lights[i], position);
+    
+            texels[y * lightmap_width + x] = (unsigned char) (glm::min(brightness, 1.0f) * 255.0f + 0.5f);
         }
     }
     
-    this->left_bound   = 0 - (this->tile_size / 2);
-    this->right_bound  = (this->tile_size * this->width) - (this->tile_size / 2);
-    this->top_bound    = 0 + (this->tile_size / 2);
-    this->bottom_bound = -(this->tile_size * this->height) + (this->tile_size / 2);
+    GLuint spare_id = 0;
+    if (region->lightmap_texture_id == 0 && !this->spare_lightmaps.empty())
+    {
+        spare_id = this->spare_lightmaps.back();
+        this->spare_lightmaps.pop_back();
+    }
+    
+    // The render thread uploads it when it next gets the chance and only then sets the region's id, so a
+    // region that has just come into view draws unlit for a frame rather than the simulation waiting
+    region->resources = this->resources;
+    this->resources->upload_luminance(&region->lightmap_texture_id, spare_id, std::move(texels), lightmap_width, lightmap_height, this->regions[index]);
+}
+
+void Map::snapshot(RenderSnapshot *snapshot) const
+{
+    snapshot->map_texture_id = this->texture_id;
+    
+    // Everything active is within PREFETCH of the focus, since stream() has just made it so
+    int first = std::max(0, this->focus_region - REGION_PREFETCH_RADIUS);
+    int last = std::min((int) this->regions.size() - 1, this->focus_region + REGION_PREFETCH_RADIUS);
+    
+    for (int i = first; i <= last; i++)
+    {
+        if (is_region_active(i)) snapshot->map_regions.push_back(this->regions[i]);
+    }
+}
+
+size_t const Map::get_geometry_bytes() const
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < this->open_regions.size(); i++) bytes += this->regions[this->open_regions[i]]->level->get_geometry_bytes();
+    
+    return bytes;
 }
 
-void Map::render(ShaderProgram *program)
+static void bind_lightmap(ShaderProgram *program, const MapRegion *region)
+{
+    // 0 means "no static light"
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, region != nullptr ? (GLuint) region->lightmap_texture_id : 0);
+    glActiveTexture(GL_TEXTURE0);
+    COUNTER_ADD(COUNTER_TEXTURE_BINDS, 1);
+    
+    if (region == nullptr) return;
+    
+    const LevelFileHeader &header = region->level->get_header();
+    program->SetLightmap(glm::vec2(header.left_bound, header.bottom_bound),
+                         glm::vec2(header.right_bound - header.left_bound, header.top_bound - header.bottom_bound));
+}
+
+void Map::render(ShaderProgram *program, Lighting *lighting, Resources *resources, GLuint texture_id, const MapRegionList &regions)
 {
     glm::mat4 model_matrix = glm::mat4(1.0f);
     program->SetModelMatrix(model_matrix);
     
     glUseProgram(program->programID);
     
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, this->vertices.data());
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, this->texture_coordinates.data());
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    resources->bind_texture(program, texture_id);
+    COUNTER_ADD(COUNTER_TEXTURE_BINDS, 1);
+    
+    // Sprites drawn after the map take their static light from the region in the middle of the screen
+    const MapRegion *sprite_region = nullptr;
+    const MapRegion *bound_region = nullptr;
+    
+    for (size_t r = 0; r < regions.size(); r++)
+    {
+        const MapRegion *region = regions[r].get();
+        const Level *region_level = region->level.get();
+        const LevelFileHeader &header = region_level->get_header();
     
-    glBindTexture(GL_TEXTURE_2D, this->texture_id);
+        if (lighting != nullptr)
+        {
+            float center_x = lighting->get_view_center().x;
+            if (sprite_region == nullptr || (center_x >= header.left_bound && center_x <= header.right_bound)) sprite_region = region;
+    
+            if (!lighting->is_visible(glm::vec2(header.left_bound, header.bottom_bound), glm::vec2(header.right_bound, header.top_bound))) continue;
+        }
+        else if (sprite_region == nullptr) sprite_region = region;
+    
+        if (header.vertex_count == 0) continue;
+    
+        glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, region_level->get_vertices());
+        glEnableVertexAttribArray(program->positionAttribute);
+        glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, region_level->get_texture_coordinates());
+        glEnableVertexAttribArray(program->texCoordAttribute);
+    
+        // Merged quads count their UVs in tiles; fragment_lit.glsl wraps them inside each quad's tileset cell
+        glVertexAttribPointer(program->tileCellAttribute, 4, GL_FLOAT, false, 0, region_level->get_tile_cells());
+        glEnableVertexAttribArray(program->tileCellAttribute);
+    
+        bind_lightmap(program, region);
+        bound_region = region;
+    
+        if (lighting == nullptr)
+        {
+            glDrawArrays(GL_TRIANGLES, 0, (int) header.vertex_count);
+            COUNTER_ADD(COUNTER_DRAW_CALLS, 1);
+            continue;
+        }
+    
+        // One draw per chunk on screen, each with only the lights that reach it
+        const LevelChunk *chunks = region_level->get_chunks();
+        for (uint32_t i = 0; i < header.chunk_count; i++)
+        {
+            const LevelChunk &chunk = chunks[i];
+            glm::vec2 min = glm::vec2(chunk.min_x, chunk.min_y);
+            glm::vec2 max = glm::vec2(chunk.max_x, chunk.max_y);
+            if (!lighting->is_visible(min, max)) continue;
+    
+            lighting->upload(program, min, max);
+            glDrawArrays(GL_TRIANGLES, chunk.first_vertex, chunk.vertex_count);
+            COUNTER_ADD(COUNTER_DRAW_CALLS, 1);
+        }
+    }
+    
+    // The lightmap stays bound on unit 1 for the sprites drawn after the map
+    if (bound_region != sprite_region || sprite_region == nullptr) bind_lightmap(program, sprite_region);
+    
+    // Leave the screen-wide set behind for the sprites drawn after us
+    if (lighting != nullptr) lighting->upload_visible(program);
     
-    glDrawArrays(GL_TRIANGLES, 0, (int) this->vertices.size() / 2);
     glDisableVertexAttribArray(program->positionAttribute);
     glDisableVertexAttribArray(program->texCoordAttribute);
+    glDisableVertexAttribArray(program->tileCellAttribute);
 }
 
 bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)
 {
+    COUNTER_ADD(COUNTER_IS_SOLID_CALLS, 1);
+    
     *penetration_x = 0;
     *penetration_y = 0;
     
@@ -92,8 +383,10 @@ bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_
     if (tile_x < 0 || tile_x >= this->width) return false;
     if (tile_y < 0 || tile_y >= this->height) return false;
     
-    int tile = level_data[tile_y * this->width + tile_x];
-    if (tile == 0) return false;
+    int index = tile_x / this->region_width;
+    if (!is_region_active(index)) return false;
+    
+    if (!this->regions[index]->level->is_solid(tile_x - index * this->region_width, tile_y)) return false;
     
     float tile_center_x = (tile_x * this->tile_size);
     float tile_center_y = -(tile_y * this->tile_size);
@@ -103,3 +396,41 @@ bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_
     
     return true;
 }
+
+bool Map::touches_solid(glm::vec3 position, float width, float height) const
+{
+    // A little slack so that rounding in is_solid's tile lookup can never find a tile we ruled out
+    float margin = this->tile_size * 0.01f;
+    
+    float min_x = position.x - (width / 2) - margin,  max_x = position.x + (width / 2) + margin;
+    float min_y = position.y - (height / 2) - margin, max_y = position.y + (height / 2) + margin;
+    
+    // Only the regions under the box; their boxes are baked in world space already
+    int first = (int) floor((min_x + (this->tile_size / 2)) / this->tile_size) / this->region_width;
+    int last = (int) floor((max_x + (this->tile_size / 2)) / this->tile_size) / this->region_width;
+    first = std::max(first, 0);
+    last = std::min(last, (int) this->regions.size() - 1);
+    
+    for (int r = first; r <= last; r++)
+    {
+        if (!is_region_active(r)) continue;
+    
+        const Level *region_level = this->regions[r]->level.get();
+        const LevelChunk *chunks = region_level->get_chunks();
+        const LevelBox *boxes = region_level->get_boxes();
+    
+        for (uint32_t i = 0; i < region_level->get_header().chunk_count; i++)
+        {
+            const LevelChunk &chunk = chunks[i];
+            if (max_x < chunk.min_x || min_x > chunk.max_x || max_y < chunk.min_y || min_y > chunk.max_y) continue;
+    
+            for (int j = chunk.first_box; j < chunk.first_box + chunk.box_count; j++)
+            {
+                const LevelBox &box = boxes[j];
+                if (max_x >= box.min_x && min_x <= box.max_x && max_y >= box.min_y && min_y <= box.max_y) return true;
+            }
+        }
+    }
+    
+    return false;
+}
@@ -4,6 +4,8 @@
 #include <GL/glew.h>
 #endif
 #define GL_GLEXT_PROTOTYPES 1
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <math.h>
 #include <SDL.h>
@@ -12,45 +14,113 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "Level.h"
+
+// Lightmap resolution; static lighting is smooth enough that a few texels per tile will do
+#define LIGHTMAP_TEXELS_PER_TILE 8
+
+// How far a streamed map looks from the focus, in regions either side of the one it's in. Regions
+// become active (drawn, collided with, populated) within ACTIVE and stay so out to PREFETCH, so that
+// standing on a border doesn't churn them; they are opened ahead of time out to PREFETCH and closed past EVICT.
+#define REGION_ACTIVE_RADIUS   1
+#define REGION_PREFETCH_RADIUS 2
+#define REGION_EVICT_RADIUS    3
+
+class Lighting;
+class Resources;
+class RegionLoader;
+class RenderSnapshot;
+
+// One open region and the lightmap baked for it. Snapshots hold on to the regions they draw, so a
+// region the simulation closes stays open until no frame still needs it.
+struct MapRegion
+{
+    std::shared_ptr<Level> level;
+    std::atomic<GLuint> lightmap_texture_id{0};     // Baked by the simulation, set and bound by the renderer; 0 is unlit
+    Resources *resources = nullptr;                 // Where the lightmap came from, and goes back to
+
+    // Whichever thread lets go of the region last hands its lightmap back
+    ~MapRegion();
+
+    // Simulation thread only
+    bool active = false;
+    bool needs_lightmap = false;
+};
+
+typedef std::vector<std::shared_ptr<const MapRegion>> MapRegionList;
 
 class Map {
 private:
     int width;
     int height;
     
-    unsigned int *level_data;
+    std::shared_ptr<Level> level;   // The whole map, or a streamed map's index
     GLuint texture_id;
     
     float tile_size;
     int tile_count_x;
     int tile_count_y;
     
-    std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    // One per region, null while closed. A map that isn't streamed is one region, always active.
+    std::vector<std::shared_ptr<MapRegion>> regions;
+    std::vector<int> open_regions;
+    std::vector<bool> broken_regions;   // Missing or mismatched files: never opened, so open air and nothing drawn
+    int region_width;
+    int focus_region = 0;
+    RegionLoader *loader = nullptr;
+    Resources *resources;
+    
+    // Lightmaps of closed regions, handed to the next ones opened so textures never pile up
+    std::vector<GLuint> spare_lightmaps;
     
     float left_bound, right_bound, top_bound, bottom_bound;
     
+    void open_region(int index, Level *region_level);
+    void close_region(int index);
+    void bake_lightmap(int index, const Lighting *lighting);
+    
 public:
-    Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int
-    tile_count_x, int tile_count_y);
+    // Takes ownership of the level, which must be valid; its baked geometry is used in place for as long as the map lives.
+    // A streaming index opens its regions as stream() asks for them. Lightmaps are made through resources.
+    Map(Level *level, GLuint texture_id, Resources *resources);
+    ~Map();
     
-    void build();
-    void render(ShaderProgram *program);
+    // Makes the regions around focus active, opens the ones just past them in the background and closes those far behind,
+    // then bakes any lightmaps that are out of date from the scene's static lights and the light spawns of active regions.
+    // What is active depends only on where focus has been, never on how far the loader has got, so replays stay exact.
+    void stream(glm::vec3 focus, const Lighting *lighting);
+    
+    // Hands the active regions to a snapshot, which keeps them open until it is done with
+    void snapshot(RenderSnapshot *snapshot) const;
+    // Render thread only: draws regions a snapshot holds. Static, so a snapshot never needs the Map
+    // itself, which goes away with its scene's arena
+    static void render(ShaderProgram *program, Lighting *lighting, Resources *resources, GLuint texture_id, const MapRegionList &regions);
+    
+    // Only active regions are solid; anywhere else is open air
     bool is_solid(glm::vec3 position, float *penetration_x, float *penetration_y);
     
+    // Whether any solid box comes near a width x height box centred on position. When none does,
+    // no probe inside it can land on a solid tile, so callers can skip asking is_solid at all.
+    bool touches_solid(glm::vec3 position, float width, float height) const;
+    
     // Getters
     int const get_width()  const  { return this->width;  }
     int const get_height() const  { return this->height; }
     
-    unsigned int* const get_level_data() const { return this->level_data; }
+    const Level  *get_level()      const { return this->level.get(); }
     GLuint        const get_texture_id() const { return this->texture_id; }
     
     float const get_tile_size() const { return this->tile_size; }
     int const get_tile_count_x() const { return this->tile_count_x; }
     int const get_tile_count_y() const { return this->tile_count_y; }
     
-    std::vector<float> const get_vertices()            const { return this->vertices;             }
-    std::vector<float> const get_texture_coordinates() const { return this-> texture_coordinates; }
+    int const get_region_count() const { return (int) this->regions.size(); }
+    int const get_region_width() const { return this->region_width; }
+    bool const is_region_active(int index) const { return this->regions[index] != nullptr && this->regions[index]->active; }
+    // Null unless the region is open
+    const Level *get_region_level(int index) const { return this->regions[index] != nullptr ? this->regions[index]->level.get() : nullptr; }
+    // Baked geometry of every open region
+    size_t const get_geometry_bytes() const;
     
     float const get_left_bound()   const { return this->left_bound;   }
     float const get_right_bound()  const { return this->right_bound;  }
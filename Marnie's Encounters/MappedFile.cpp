@@ -0,0 +1,64 @@
+#include "MappedFile.h"
+
+#ifdef _WINDOWS
+#include <windows.h>
+
+MappedFile::MappedFile(const char *filepath)
+{
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+    this->file_handle = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return;
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) return;
+    this->mapping_handle = mapping;
+
+    this->bytes = (const unsigned char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (this->bytes != nullptr) this->length = (size_t) file_size.QuadPart;
+}
+
+MappedFile::~MappedFile()
+{
+    if (this->bytes != nullptr) UnmapViewOfFile(this->bytes);
+    if (this->mapping_handle != nullptr) CloseHandle((HANDLE) this->mapping_handle);
+    if (this->file_handle != nullptr) CloseHandle((HANDLE) this->file_handle);
+}
+
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile(const char *filepath)
+{
+    this->descriptor = open(filepath, O_RDONLY);
+    if (this->descriptor < 0) return;
+
+    struct stat status;
+    if (fstat(this->descriptor, &status) != 0 || status.st_size == 0) return;
+
+    void *mapped = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, this->descriptor, 0);
+    if (mapped == MAP_FAILED) return;
+
+    this->bytes = (const unsigned char*) mapped;
+    this->length = (size_t) status.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+    if (this->bytes != nullptr) munmap((void*) this->bytes, this->length);
+    if (this->descriptor >= 0) close(this->descriptor);
+}
+
+#endif
+
+void MappedFile::touch() const
+{
+    // 4 KB is the smallest page size anywhere we run; volatile keeps the reads from being optimised away
+    volatile unsigned char sink = 0;
+    for (size_t offset = 0; offset < this->length; offset += 4096) sink = sink + this->bytes[offset];
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+
+// A whole file mapped read-only into memory. Pages are read in by the OS the first time they're
+// touched, so opening is cheap however large the file is, and nothing is copied.
+class MappedFile {
+    const unsigned char *bytes = nullptr;
+    size_t length = 0;
+
+#ifdef _WINDOWS
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#else
+    int descriptor = -1;
+#endif
+
+public:
+    MappedFile(const char *filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    bool const is_open() const { return bytes != nullptr; };
+
+    const unsigned char *data() const { return bytes; };
+    size_t const size() const { return length; };
+
+    // Reads one byte of every page, so that nothing using the file later has to wait for the disk
+    void touch() const;
+};
@@ -0,0 +1,114 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Memory.h"
+#include <string.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+static const char* const MEMORY_KIND_NAMES[MEMORY_KIND_COUNT] =
+{
+    "textures",
+    "lightmaps",
+    "audio",
+    "map geometry",
+    "entities",
+    "arenas"
+};
+
+struct OwnerMemory
+{
+    const char *owner;
+    int64_t bytes[MEMORY_KIND_COUNT];
+};
+
+// Only changed on loads and reports, so a lock is cheap enough
+static std::mutex owners_mutex;
+static OwnerMemory owners[MEMORY_MAX_OWNERS];
+static int owner_count = 0;
+
+static thread_local const char *thread_owner = nullptr;
+
+// The same name from two places is one owner. Call with the lock held.
+static OwnerMemory *owner_memory(const char *owner)
+{
+    for (int i = 0; i < owner_count; i++)
+    {
+        if (strcmp(owners[i].owner, owner) == 0) return &owners[i];
+    }
+
+    if (owner_count == MEMORY_MAX_OWNERS)
+    {
+        LOG("More than " << MEMORY_MAX_OWNERS << " memory owners; " << owner << " is counted as " << owners[owner_count - 1].owner);
+        return &owners[owner_count - 1];
+    }
+
+    OwnerMemory *memory = &owners[owner_count++];
+    memory->owner = owner;
+    for (int i = 0; i < MEMORY_KIND_COUNT; i++) memory->bytes[i] = 0;
+    return memory;
+}
+
+void Memory::add(MemoryKind kind, const char *owner, int64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(owners_mutex);
+    owner_memory(owner)->bytes[kind] += bytes;
+}
+
+void Memory::set(MemoryKind kind, const char *owner, int64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(owners_mutex);
+    owner_memory(owner)->bytes[kind] = bytes;
+}
+
+const char *Memory::current_owner()
+{
+    return thread_owner != nullptr ? thread_owner : "shared";
+}
+
+void Memory::set_current_owner(const char *owner)
+{
+    thread_owner = owner;
+}
+
+int64_t const Memory::get(MemoryKind kind, const char *owner)
+{
+    std::lock_guard<std::mutex> lock(owners_mutex);
+    return owner_memory(owner)->bytes[kind];
+}
+
+const char* const Memory::get_name(MemoryKind kind)
+{
+    return MEMORY_KIND_NAMES[kind];
+}
+
+void Memory::report()
+{
+    std::lock_guard<std::mutex> lock(owners_mutex);
+    int64_t gpu = 0, cpu = 0;
+
+    // Tenths of a KB, without leaving the stream that way for whoever prints next
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1);
+
+    LOG("resident memory (KB):");
+    for (int i = 0; i < owner_count; i++)
+    {
+        const OwnerMemory &memory = owners[i];
+
+        std::cout << "    " << memory.owner << ":";
+        for (int kind = 0; kind < MEMORY_KIND_COUNT; kind++)
+        {
+            std::cout << " " << MEMORY_KIND_NAMES[kind] << " " << memory.bytes[kind] / 1024.0;
+
+            if (kind == MEMORY_TEXTURES || kind == MEMORY_LIGHTMAPS) gpu += memory.bytes[kind];
+            else cpu += memory.bytes[kind];
+        }
+        std::cout << '\n';
+    }
+
+    LOG("    gpu " << gpu / 1024.0 << ", cpu " << cpu / 1024.0);
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// What memory is held for; the first two live on the GPU
+enum MemoryKind
+{
+    MEMORY_TEXTURES,
+    MEMORY_LIGHTMAPS,
+    MEMORY_AUDIO,
+    MEMORY_MAP_GEOMETRY,    // Baked vertices, chunks and boxes of every open level
+    MEMORY_ENTITIES,        // Wherever entities live
+    MEMORY_ARENAS,          // Blocks held, used or not, less the entities in them
+    MEMORY_KIND_COUNT
+};
+
+// Owners and kinds remembered in all
+#define MEMORY_MAX_OWNERS 32
+
+// Resident memory by owner and kind. Owners are string literals, scene names mostly. Loads are charged to
+// the owner current on the loading thread, so a texture shared by several scenes counts for the first that
+// asked for it; figures a scene can simply measure are set outright whenever a report is due.
+class Memory {
+public:
+    static void add(MemoryKind kind, const char *owner, int64_t bytes);
+    static void set(MemoryKind kind, const char *owner, int64_t bytes);
+
+    // Who loads on this thread are charged to, "shared" outside every MemoryOwner
+    static const char *current_owner();
+    static void set_current_owner(const char *owner);
+
+    static int64_t const get(MemoryKind kind, const char *owner);
+    static const char* const get_name(MemoryKind kind);
+
+    // One line per owner, GPU and CPU totals at the end
+    static void report();
+};
+
+// Charges whatever this thread loads to owner until the end of the scope
+class MemoryOwner {
+    const char *previous;
+
+public:
+    MemoryOwner(const char *owner) : previous(Memory::current_owner()) { Memory::set_current_owner(owner); }
+    ~MemoryOwner() { Memory::set_current_owner(previous); }
+};
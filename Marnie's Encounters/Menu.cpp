@@ -1,58 +1,51 @@
 #include "Menu.h"
 #include "Utility.h"
+#include "Counters.h"
 
-#define LEVEL_WIDTH 23
-#define LEVEL_HEIGHT 8
 #define LOG(argument) std::cout << argument << '\n'
 
 const int FONTBANK_SIZE = 16;
 
-unsigned int Menu_DATA[] =
+// Every texture the scene draws with, asked for together so they decode in parallel
+const char* const MENU_TEXTURES[] =
 {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    "assets/tileset.png",
+    "assets/font1.png",
+    "assets/marnie_0.png",
+    "assets/trainer3.png",
+    "assets/trainer3_flip.png",
+    "assets/trainer1.png",
+    "assets/trainer2.png"
 };
-
-Menu::~Menu()
-{
-    delete[] this->state.enemies;
-    delete    this->state.player;
-    delete    this->state.map;
-    Mix_FreeChunk(this->state.jump_sfx);
-    Mix_FreeMusic(this->state.bgm);
-}
+const int MENU_TEXTURE_COUNT = sizeof(MENU_TEXTURES) / sizeof(MENU_TEXTURES[0]);
 
 void Menu::initialise()
 {
     state.next_scene_id = -1;
+    state.resources->preload_textures(MENU_TEXTURES, MENU_TEXTURE_COUNT);
 
-    GLuint map_texture_id = Utility::load_texture("assets/tileset.png");
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, Menu_DATA, map_texture_id, 1.0f, 4, 1);
+    GLuint map_texture_id = state.resources->texture("assets/tileset.png");
+    font_texture_id = state.resources->texture("assets/font1.png");
+    this->state.map = arena.create<Map>(new Level("levels/menu.lvl"), map_texture_id, state.resources);
 
     // Code from main.cpp's initialise()
     /**
      George's Stuff
      */
      // Existing
-    state.player = new Entity();
+    state.player = arena.create<Entity>();
     state.player->set_entity_type(PLAYER);
-    state.player->set_position(glm::vec3(2.0f, 1.0f, 0.0f));
+    state.player->set_position(player_spawn());
     state.player->set_movement(glm::vec3(0.0f));
     state.player->speed = 3.5f;
     state.player->set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/marnie_0.png");
+    state.player->texture_id = state.resources->texture("assets/marnie_0.png");
 
     // Walking
-    state.player->walking[state.player->LEFT] = new int[4]{ 1, 5, 9,  13 };
-    state.player->walking[state.player->RIGHT] = new int[4]{ 3, 7, 11, 15 };
-    state.player->walking[state.player->UP] = new int[4]{ 2, 6, 10, 14 };
-    state.player->walking[state.player->DOWN] = new int[4]{ 0, 4, 8,  12 };
+    state.player->walking[state.player->LEFT] = arena.copy_array({ 1, 5, 9,  13 });
+    state.player->walking[state.player->RIGHT] = arena.copy_array({ 3, 7, 11, 15 });
+    state.player->walking[state.player->UP] = arena.copy_array({ 2, 6, 10, 14 });
+    state.player->walking[state.player->DOWN] = arena.copy_array({ 0, 4, 8,  12 });
 
     state.player->animation_indices = state.player->walking[state.player->RIGHT];  // start George looking left
     state.player->animation_frames = 4;
@@ -68,12 +61,12 @@ void Menu::initialise()
 
     /**
      Enemies' stuff */
-    GLuint enemy1_texture_id = Utility::load_texture("assets/trainer3.png");
-    GLuint enemy1_texture_id2 = Utility::load_texture("assets/trainer3_flip.png");
-    GLuint enemy2_texture_id = Utility::load_texture("assets/trainer1.png");
-    GLuint enemy3_texture_id = Utility::load_texture("assets/trainer2.png");
+    GLuint enemy1_texture_id = state.resources->texture("assets/trainer3.png");
+    GLuint enemy1_texture_id2 = state.resources->texture("assets/trainer3_flip.png");
+    GLuint enemy2_texture_id = state.resources->texture("assets/trainer1.png");
+    GLuint enemy3_texture_id = state.resources->texture("assets/trainer2.png");
 
-    state.enemies = new Entity[this->ENEMY_COUNT];
+    state.enemies = arena.create_array<Entity>(this->ENEMY_COUNT);
     state.enemies[0].set_entity_type(ENEMY);
     state.enemies[0].set_ai_type(WALKER);
     state.enemies[0].set_ai_state(IDLE);
@@ -87,6 +80,9 @@ void Menu::initialise()
 }
 
 void Menu::update(float delta_time) {
+    PROFILE_ZONE("Menu::update");
+    COUNTER_SET(COUNTER_ENTITIES, 1 + ENEMY_COUNT);
+
     this->state.player->update(delta_time, state.player, state.enemies, this->ENEMY_COUNT, this->state.map);
 
     for (int i = 0; i < ENEMY_COUNT; i++) {
@@ -94,13 +90,13 @@ void Menu::update(float delta_time) {
     }
 }
 
-void Menu::render(ShaderProgram *program) {
-    this->state.map->render(program);
-    //this->state.player->render(program);
+void Menu::snapshot(RenderSnapshot *snapshot) {
+    this->state.map->snapshot(snapshot);
+    //this->state.player->snapshot(snapshot);
 
     for (int i = 0; i < ENEMY_COUNT; i++) {
-        //state.enemies[i].render(program);
+        //state.enemies[i].snapshot(snapshot);
     }
-    Utility::draw_text(program, Utility::load_texture("assets/font1.png"), "Marnie's Adventure", 0.5f, 0.0f, glm::vec3(0.9f, -3.0f, 0.0f));
-    Utility::draw_text(program, Utility::load_texture("assets/font1.png"), "Press ENTER to begin", 0.3f, 0.0001f, glm::vec3(2.2f, -4.0f, 0.0f));
+    snapshot->add_text(font_texture_id, "Marnie's Adventure", 0.5f, 0.0f, glm::vec3(0.9f, -3.0f, 0.0f));
+    snapshot->add_text(font_texture_id, "Press ENTER to begin", 0.3f, 0.0001f, glm::vec3(2.2f, -4.0f, 0.0f));
 }
@@ -4,11 +4,15 @@ class Menu : public Scene {
 public:
     int ENEMY_COUNT = 1;
     
-    ~Menu();
-
     bool played = false;
+    GLuint font_texture_id = 0;
     
     void initialise() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
+    void snapshot(RenderSnapshot *snapshot) override;
+
+    // Only the map and the title are drawn, and neither moves
+    bool const is_static() const override { return true; }
+    
+    int arena_entity_count() const override { return state.player != nullptr ? 1 + this->ENEMY_COUNT : 0; }
 };
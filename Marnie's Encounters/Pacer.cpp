@@ -0,0 +1,40 @@
+#include "Pacer.h"
+#include "Profiler.h"
+#include <chrono>
+#include <thread>
+
+FramePacer::FramePacer()
+{
+    this->frequency = SDL_GetPerformanceFrequency();
+    this->min_spin_ticks = seconds_to_ticks(PACER_MIN_SPIN_SECONDS);
+    this->max_spin_ticks = seconds_to_ticks(PACER_MAX_SPIN_SECONDS);
+    this->spin_ticks = this->max_spin_ticks;
+}
+
+void FramePacer::wait_until(Uint64 deadline)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now >= deadline) return;
+
+    PROFILE_ZONE("wait");
+
+    // nanosleep on POSIX; whatever the scheduler gives us elsewhere, which is why we stop short
+    if (deadline - now > this->spin_ticks)
+    {
+        Uint64 wake = deadline - this->spin_ticks;
+        std::this_thread::sleep_for(std::chrono::nanoseconds((wake - now) * 1000000000ull / this->frequency));
+
+        // Jump straight up to a worse overshoot, but only ease back down from a better one.
+        // A sleep that was preempted outright says nothing about the timer, hence the ceiling.
+        Uint64 woke = SDL_GetPerformanceCounter();
+        Uint64 overshoot = woke > wake ? woke - wake : 0;
+
+        if (overshoot > this->spin_ticks) this->spin_ticks = overshoot;
+        else this->spin_ticks -= (this->spin_ticks - overshoot) / 16;
+
+        if (this->spin_ticks < this->min_spin_ticks) this->spin_ticks = this->min_spin_ticks;
+        if (this->spin_ticks > this->max_spin_ticks) this->spin_ticks = this->max_spin_ticks;
+    }
+
+    while (SDL_GetPerformanceCounter() < deadline) std::this_thread::yield();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <SDL.h>
+
+// Sleeps can overshoot by a scheduler tick, so the last stretch before a deadline is spun instead.
+// The stretch starts at the most and then tracks how late this machine's sleeps actually wake up.
+#define PACER_MAX_SPIN_SECONDS 0.002f
+#define PACER_MIN_SPIN_SECONDS 0.0002f
+
+// Waits for points on the performance counter without burning a core to do it.
+// Most of the wait is a real sleep; only the final spin_ticks are spent polling the clock.
+// One per thread: it learns from its own sleeps.
+class FramePacer {
+    Uint64 frequency;
+    Uint64 spin_ticks;
+    Uint64 min_spin_ticks, max_spin_ticks;
+
+public:
+    FramePacer();
+
+    // Returns at (or just after) deadline, a value of SDL_GetPerformanceCounter(); at once if that's past
+    void wait_until(Uint64 deadline);
+
+    Uint64 const seconds_to_ticks(float seconds) const { return (Uint64) (seconds * this->frequency); };
+};
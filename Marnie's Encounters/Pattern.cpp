@@ -0,0 +1,223 @@
+#include "Pattern.h"
+#include "Profiler.h"
+#include "glm/trigonometric.hpp"
+#include <math.h>
+#include <string.h>
+
+static inline uint32_t float_word(float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+static inline float word_float(uint32_t word)
+{
+    float value;
+    memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+PatternBuilder &PatternBuilder::op(PatternOp op)
+{
+    code.push_back((uint32_t) op);
+    return *this;
+}
+
+PatternBuilder &PatternBuilder::operand(float value)
+{
+    code.push_back(float_word(value));
+    return *this;
+}
+
+std::vector<uint32_t> const &PatternBuilder::build()
+{
+    if (code.empty() || code.back() != OP_END) code.push_back(OP_END);
+    return code;
+}
+
+void PatternVM::reset(RngBulk *rng)
+{
+    code.clear();
+    emitters.clear();
+    code.reserve(PATTERN_CODE_RESERVE);
+    emitters.reserve(PATTERN_EMITTER_RESERVE);
+    time = 0.0f;
+
+    this->rng = rng;
+    randoms_left = 0;
+}
+
+int PatternVM::load(PatternBuilder &pattern)
+{
+    const std::vector<uint32_t> &program = pattern.build();
+
+    int handle = (int) code.size();
+    code.insert(code.end(), program.begin(), program.end());
+
+    return handle;
+}
+
+void PatternVM::start(int program, float interval)
+{
+    PatternEmitter emitter;
+    emitter.program = program;
+    emitter.interval = interval;
+    emitter.last_fired = time - interval;
+
+    emitters.push_back(emitter);
+}
+
+float PatternVM::next_random(float a, float b)
+{
+    // Bursts ask for many numbers at once, so they are made a block at a time
+    if (randoms_left == 0)
+    {
+        rng->fill(randoms, PATTERN_RANDOM_BLOCK, 0.0f, 1.0f);
+        randoms_left = PATTERN_RANDOM_BLOCK;
+    }
+
+    return a + (b - a) * randoms[PATTERN_RANDOM_BLOCK - randoms_left--];
+}
+
+void PatternVM::update(float delta_time, glm::vec2 player_position, ProjectileStore *projectiles)
+{
+    PROFILE_ZONE("PatternVM::update");
+
+    time += delta_time;
+
+    for (size_t i = 0; i < emitters.size(); i++)
+    {
+        PatternEmitter &emitter = emitters[i];
+        if (time - emitter.last_fired > emitter.interval)
+        {
+            emitter.last_fired = time;
+            run(emitter.program, player_position, projectiles);
+        }
+    }
+}
+
+void PatternVM::run(int program, glm::vec2 player_position, ProjectileStore *projectiles)
+{
+    // Registers; every shot starts from the same defaults
+    glm::vec2 origin = glm::vec2(0.0f);
+    glm::vec2 direction = glm::vec2(0.0f, -1.0f);
+    float speed = 1.0f, target_speed = 1.0f, acceleration = 0.0f;
+    float size = 0.5f;
+    int texture = 0;
+    int fan_count = 1;
+    float fan_spread = 0.0f;
+
+    const uint32_t *pc = code.data() + program;
+
+    while (true)
+    {
+        switch ((PatternOp) *pc++)
+        {
+            case OP_END:
+                return;
+
+            case OP_ORIGIN:
+                origin = glm::vec2(word_float(pc[0]), word_float(pc[1]));
+                pc += 2;
+                break;
+
+            case OP_ORIGIN_RANDOM_X:
+                origin = glm::vec2(next_random(word_float(pc[0]), word_float(pc[1])), word_float(pc[2]));
+                pc += 3;
+                break;
+
+            case OP_ORIGIN_RANDOM_Y:
+                origin = glm::vec2(word_float(pc[0]), next_random(word_float(pc[1]), word_float(pc[2])));
+                pc += 3;
+                break;
+
+            case OP_ORIGIN_PLAYER_Y:
+                origin = glm::vec2(word_float(pc[0]), player_position.y);
+                pc += 1;
+                break;
+
+            case OP_ORIGIN_RANDOM_EDGE:
+            {
+                float x0 = word_float(pc[0]), x1 = word_float(pc[1]);
+                float y0 = word_float(pc[2]), y1 = word_float(pc[3]);
+                pc += 4;
+
+                // Half the time along the top or bottom, otherwise along a side
+                if (next_random(0.0f, 1.0f) < 0.5f) {
+                    origin.x = next_random(x0, x1);
+                    origin.y = next_random(0.0f, 1.0f) < 0.5f ? y0 : y1;
+                } else {
+                    origin.y = next_random(y0, y1);
+                    origin.x = next_random(0.0f, 1.0f) < 0.5f ? x0 : x1;
+                }
+                break;
+            }
+
+            case OP_DIRECTION:
+                direction = glm::vec2(word_float(pc[0]), word_float(pc[1]));
+                pc += 2;
+                break;
+
+            case OP_AIM:
+            {
+                float angle = atan2f(player_position.y - origin.y, player_position.x - origin.x);
+                direction = glm::vec2(cosf(angle), sinf(angle));
+                break;
+            }
+
+            case OP_SPEED:
+                speed = target_speed = word_float(pc[0]);
+                acceleration = 0.0f;
+                pc += 1;
+                break;
+
+            case OP_SPEED_CURVE:
+                speed = word_float(pc[0]);
+                target_speed = word_float(pc[1]);
+                acceleration = word_float(pc[2]);
+                pc += 3;
+                break;
+
+            case OP_SIZE:
+                size = word_float(pc[0]);
+                pc += 1;
+                break;
+
+            case OP_TEXTURE:
+                texture = (int) word_float(pc[0]);
+                pc += 1;
+                break;
+
+            case OP_FAN:
+                fan_count = (int) word_float(pc[0]);
+                fan_spread = word_float(pc[1]);
+                pc += 2;
+                break;
+
+            case OP_EMIT:
+            {
+                if (fan_count <= 1) {
+                    projectiles->spawn(origin, direction, speed, target_speed, acceleration, size, texture);
+                    break;
+                }
+
+                // Spread the fan evenly either side of the current direction
+                float base = atan2f(direction.y, direction.x);
+                float step = glm::radians(fan_spread) / (fan_count - 1);
+                float first = base - glm::radians(fan_spread) / 2.0f;
+
+                for (int i = 0; i < fan_count; i++)
+                {
+                    float angle = first + step * i;
+                    projectiles->spawn(origin, glm::vec2(cosf(angle), sinf(angle)), speed, target_speed, acceleration, size, texture);
+                }
+                break;
+            }
+
+            default:
+                // Unknown opcode: the program is broken, so stop rather than read garbage
+                return;
+        }
+    }
+}
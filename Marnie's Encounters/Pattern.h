@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "glm/vec2.hpp"
+#include "Projectiles.h"
+#include "Random.h"
+
+// Random numbers are drawn in blocks of this many through RngBulk
+#define PATTERN_RANDOM_BLOCK 64
+
+// Room reset() makes for bytecode and emitters, so loading a shot mid-encounter doesn't allocate
+#define PATTERN_CODE_RESERVE 1024
+#define PATTERN_EMITTER_RESERVE 16
+
+// Every instruction is one opcode word followed by its float operands, stored bit for bit as words
+enum PatternOp
+{
+    OP_END,
+    OP_ORIGIN,              // x y
+    OP_ORIGIN_RANDOM_X,     // x0 x1 y:       somewhere on a horizontal line
+    OP_ORIGIN_RANDOM_Y,     // x y0 y1:       somewhere on a vertical line
+    OP_ORIGIN_PLAYER_Y,     // x:             level with the player
+    OP_ORIGIN_RANDOM_EDGE,  // x0 x1 y0 y1:   somewhere on the edge of a rectangle
+    OP_DIRECTION,           // dx dy
+    OP_AIM,                 //                straight at the player
+    OP_SPEED,               // v
+    OP_SPEED_CURVE,         // v0 v1 rate:    start at v0 and ease towards v1
+    OP_SIZE,                // s
+    OP_TEXTURE,             // index:         as returned by ProjectileStore::add_texture
+    OP_FAN,                 // count spread:  the next emits fire count bullets over spread degrees
+    OP_EMIT                 //                fire with everything set so far
+};
+
+// Authoring side: describe a shot in a few calls, get its bytecode
+class PatternBuilder {
+    std::vector<uint32_t> code;
+
+    PatternBuilder &op(PatternOp op);
+    PatternBuilder &operand(float value);
+
+public:
+    PatternBuilder &origin(float x, float y)                              { return op(OP_ORIGIN).operand(x).operand(y); };
+    PatternBuilder &origin_random_x(float x0, float x1, float y)          { return op(OP_ORIGIN_RANDOM_X).operand(x0).operand(x1).operand(y); };
+    PatternBuilder &origin_random_y(float x, float y0, float y1)          { return op(OP_ORIGIN_RANDOM_Y).operand(x).operand(y0).operand(y1); };
+    PatternBuilder &origin_player_y(float x)                              { return op(OP_ORIGIN_PLAYER_Y).operand(x); };
+    PatternBuilder &origin_random_edge(float x0, float x1, float y0, float y1)
+                                                                          { return op(OP_ORIGIN_RANDOM_EDGE).operand(x0).operand(x1).operand(y0).operand(y1); };
+    PatternBuilder &direction(float dx, float dy)                         { return op(OP_DIRECTION).operand(dx).operand(dy); };
+    PatternBuilder &aim()                                                 { return op(OP_AIM); };
+    PatternBuilder &speed(float v)                                        { return op(OP_SPEED).operand(v); };
+    PatternBuilder &speed_curve(float v0, float v1, float rate)           { return op(OP_SPEED_CURVE).operand(v0).operand(v1).operand(rate); };
+    PatternBuilder &size(float s)                                         { return op(OP_SIZE).operand(s); };
+    PatternBuilder &texture(int index)                                    { return op(OP_TEXTURE).operand((float) index); };
+    PatternBuilder &fan(int count, float spread)                          { return op(OP_FAN).operand((float) count).operand(spread); };
+    PatternBuilder &emit()                                                { return op(OP_EMIT); };
+
+    std::vector<uint32_t> const &build();
+};
+
+// A compiled shot fired every interval seconds until it is stopped
+struct PatternEmitter
+{
+    int program;
+    float interval;
+    float last_fired;
+};
+
+// Runs emitters and writes what they fire straight into a ProjectileStore
+class PatternVM {
+    std::vector<uint32_t> code;
+    std::vector<PatternEmitter> emitters;
+    float time = 0.0f;
+
+    RngBulk *rng = nullptr;
+    float randoms[PATTERN_RANDOM_BLOCK];
+    int randoms_left = 0;
+
+    float next_random(float a, float b);
+    void run(int program, glm::vec2 player_position, ProjectileStore *projectiles);
+
+public:
+    void reset(RngBulk *rng);
+
+    // Copies a shot's bytecode in; the returned handle is what emitters refer to
+    int load(PatternBuilder &pattern);
+
+    // Emitters start firing on the next update; scene scripts decide how long they run for
+    void start(int program, float interval);
+    void stop_all() { emitters.clear(); };
+
+    void update(float delta_time, glm::vec2 player_position, ProjectileStore *projectiles);
+
+    float const get_time() const { return time; };
+};
@@ -0,0 +1,95 @@
+#include "PhasedUpdate.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <math.h>
+
+static inline int64_t pack_cell(int x, int y)
+{
+    return ((int64_t) x << 32) | (uint32_t) y;
+}
+
+int64_t const PhasedUpdate::cell_of(glm::vec3 position) const
+{
+    return pack_cell((int) floorf(position.x / cell_size), (int) floorf(position.y / cell_size));
+}
+
+int const PhasedUpdate::find_hit(int index, std::vector<Entity*> &entities) const
+{
+    Entity *entity = entities[index];
+    int cell_x = (int) floorf(entity->get_position().x / cell_size);
+    int cell_y = (int) floorf(entity->get_position().y / cell_size);
+
+    // Cells are at least as big as the biggest entity, so anything touching is in a neighbouring cell
+    int hit = -1;
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            BroadphaseEntry key;
+            key.cell = pack_cell(cell_x + dx, cell_y + dy);
+            key.index = -1;
+
+            for (auto it = std::lower_bound(grid.begin(), grid.end(), key); it != grid.end() && it->cell == key.cell; it++)
+            {
+                // Lowest index wins, as it did when entities were checked in order
+                if (hit >= 0 && it->index > hit) break;
+                if (entity->check_collision(entities[it->index])) hit = it->index;
+            }
+        }
+    }
+
+    return hit;
+}
+
+void PhasedUpdate::update(float delta_time, Entity *player, std::vector<Entity*> &entities, Map *map, JobSystem *jobs)
+{
+    int count = (int) entities.size();
+    if (count == 0) return;
+
+    {
+        PROFILE_ZONE("integrate");
+        jobs->parallel_for(count, PHASED_UPDATE_GRAIN, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) entities[i]->integrate(delta_time, player, map);
+        });
+    }
+
+    {
+        PROFILE_ZONE("broadphase");
+
+        // Sorting by (cell, index) gives the same grid however the entities were updated
+        cell_size = 1.0f;
+        for (int i = 0; i < count; i++) {
+            cell_size = fmaxf(cell_size, fmaxf(entities[i]->width, entities[i]->height));
+        }
+
+        grid.resize(count);
+        for (int i = 0; i < count; i++) {
+            grid[i].cell = cell_of(entities[i]->get_position());
+            grid[i].index = i;
+        }
+        std::sort(grid.begin(), grid.end());
+
+        hits.assign(count, -1);
+        jobs->parallel_for(count, PHASED_UPDATE_GRAIN, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                if (entities[i]->is_active) hits[i] = find_hit(i, entities);
+            }
+        });
+    }
+
+    {
+        PROFILE_ZONE("resolve");
+
+        for (int i = 0; i < count; i++)
+        {
+            if (hits[i] < 0) continue;
+
+            Entity *entity = entities[i];
+            Entity *other = entities[hits[i]];
+
+            if (entity->register_contact() && (other == player || entity == player)) {
+                player->deactivate();
+            }
+        }
+    }
+}
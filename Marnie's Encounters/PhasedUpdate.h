@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "Entity.h"
+#include "Jobs.h"
+
+// Entities per parallel_for slice; groups this small or smaller stay on the calling thread
+#define PHASED_UPDATE_GRAIN 128
+
+struct BroadphaseEntry
+{
+    int64_t cell;
+    int index;
+
+    bool operator<(const BroadphaseEntry &other) const
+    {
+        return cell < other.cell || (cell == other.cell && index < other.index);
+    };
+};
+
+// Updates a whole group of entities in three phases instead of one entity at a time:
+//   1. integrate:  AI, movement and the map, in parallel; each entity touches only itself
+//   2. broadphase: every entity finds the lowest-numbered entity it overlaps, in parallel, reading only
+//   3. resolve:    the consequences are applied in index order on the calling thread
+// Nothing in a phase depends on how the work was split, so any number of threads gives the same result.
+class PhasedUpdate {
+    std::vector<BroadphaseEntry> grid;
+    std::vector<int> hits;
+    float cell_size;
+
+    int64_t const cell_of(glm::vec3 position) const;
+    int const find_hit(int index, std::vector<Entity*> &entities) const;
+
+public:
+    void update(float delta_time, Entity *player, std::vector<Entity*> &entities, Map *map, JobSystem *jobs);
+};
@@ -0,0 +1,156 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// One ring per thread. Only the owning thread writes, so recording never takes a lock: it bumps claimed
+// before writing an event and head once the event is written. A dump reads up to head, then re-reads claimed
+// to find which of the slots it read may have been overwritten meanwhile. Rings are never freed, so a
+// thread's zones outlive the thread.
+struct ProfileRing
+{
+    ProfileEvent events[PROFILER_EVENTS_PER_THREAD];
+    std::atomic<uint64_t> claimed;
+    std::atomic<uint64_t> head;
+    int thread_id;
+    std::atomic<const char*> thread_name;
+};
+
+// A dump's copy of one event
+struct DumpedEvent
+{
+    const char *name;
+    uint64_t start, end;
+};
+
+// Only touched when a thread records its first event, or when dumping
+static std::mutex rings_mutex;
+static std::vector<ProfileRing*> rings;
+
+thread_local const char *profile_current_zone = nullptr;
+
+static const std::chrono::steady_clock::time_point profiler_epoch = std::chrono::steady_clock::now();
+
+static ProfileRing *thread_ring()
+{
+    thread_local ProfileRing *ring = nullptr;
+
+    if (ring == nullptr)
+    {
+        ring = new ProfileRing();
+        ring->claimed.store(0);
+        ring->head.store(0);
+        ring->thread_name.store(nullptr);
+
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        ring->thread_id = (int) rings.size();
+        rings.push_back(ring);
+    }
+
+    return ring;
+}
+
+uint64_t Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler_epoch).count();
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t end)
+{
+    ProfileRing *ring = thread_ring();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+    // A dump that reads any of this event's fields is then sure to see the claim
+    ring->claimed.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ProfileEvent &event = ring->events[head % PROFILER_EVENTS_PER_THREAD];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+const char *Profiler::current_zone()
+{
+    return profile_current_zone;
+}
+
+void Profiler::set_thread_name(const char *name)
+{
+    thread_ring()->thread_name.store(name);
+}
+
+bool Profiler::dump(const char *filepath)
+{
+    std::ofstream outfile(filepath);
+
+    if (outfile.fail())
+    {
+        LOG("Unable to write profile to " << filepath);
+        return false;
+    }
+
+    outfile << std::fixed << std::setprecision(3);
+    outfile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    std::vector<DumpedEvent> events(PROFILER_EVENTS_PER_THREAD);
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (size_t i = 0; i < rings.size(); i++)
+    {
+        ProfileRing *ring = rings[i];
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = head > PROFILER_EVENTS_PER_THREAD ? head - PROFILER_EVENTS_PER_THREAD : 0;
+
+        // Copy first, while the owner may still be recording over the oldest of them
+        for (uint64_t j = begin; j < head; j++)
+        {
+            const ProfileEvent &event = ring->events[j % PROFILER_EVENTS_PER_THREAD];
+            DumpedEvent &copy = events[j - begin];
+            copy.name  = event.name.load(std::memory_order_relaxed);
+            copy.start = event.start.load(std::memory_order_relaxed);
+            copy.end   = event.end.load(std::memory_order_relaxed);
+        }
+
+        // Event j shares its slot with event j + PROFILER_EVENTS_PER_THREAD, so every event up to
+        // that far behind the latest claim may have been torn; those are dropped
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = ring->claimed.load(std::memory_order_relaxed);
+        uint64_t intact = claimed > PROFILER_EVENTS_PER_THREAD ? claimed - PROFILER_EVENTS_PER_THREAD : 0;
+
+        const char *thread_name = ring->thread_name.load();
+        if (thread_name != nullptr)
+        {
+            outfile << (first ? "" : ",\n")
+                    << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread_id
+                    << ",\"args\":{\"name\":\"" << thread_name << "\"}}";
+            first = false;
+        }
+
+        for (uint64_t j = begin > intact ? begin : intact; j < head; j++)
+        {
+            const DumpedEvent &event = events[j - begin];
+
+            // Chrome wants microseconds; keep the fraction so sub-microsecond zones still show up
+            outfile << (first ? "" : ",\n")
+                    << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread_id
+                    << ",\"ts\":" << event.start / 1000.0
+                    << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+            first = false;
+        }
+    }
+
+    outfile << "\n]}\n";
+
+    LOG("Profile written to " << filepath);
+    return true;
+}
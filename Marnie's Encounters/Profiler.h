@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Zones are only recorded in debug builds, unless PROFILER_ENABLED is defined by hand.
+// Allocation tracking (see Allocations.h) charges allocations to zones, so it turns zones on too.
+#if !defined(PROFILER_ENABLED) && (defined(_DEBUG) || defined(DEBUG) || defined(ALLOC_TRACKING_ENABLED))
+#define PROFILER_ENABLED 1
+#endif
+
+// Events kept per thread; once full the oldest ones are overwritten
+#define PROFILER_EVENTS_PER_THREAD 65536
+
+// Relaxed atomics, so a dump can read an event while its thread overwrites it and then tell that it did
+struct ProfileEvent
+{
+    std::atomic<const char*> name;      // Must be a string literal, it is stored as-is
+    std::atomic<uint64_t> start;        // Nanoseconds since the profiler started
+    std::atomic<uint64_t> end;
+};
+
+class Profiler {
+public:
+    static uint64_t now();
+    static void record(const char *name, uint64_t start, uint64_t end);
+    static void set_thread_name(const char *name);
+
+    // Innermost zone this thread is inside, or null
+    static const char *current_zone();
+
+    // Writes every thread's recent events as a chrome://tracing / Perfetto JSON file
+    static bool dump(const char *filepath);
+};
+
+extern thread_local const char *profile_current_zone;
+
+class ProfileZone {
+    const char *name;
+    const char *parent;
+    uint64_t start;
+
+public:
+    ProfileZone(const char *name) : name(name), parent(profile_current_zone), start(Profiler::now()) { profile_current_zone = name; }
+    ~ProfileZone()
+    {
+        Profiler::record(name, start, Profiler::now());
+        profile_current_zone = parent;
+    }
+};
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::set_thread_name(name)
+#else
+#define PROFILE_ZONE(name) ((void) 0)
+#define PROFILE_THREAD(name) ((void) 0)
+#endif
@@ -0,0 +1,162 @@
+#include "Projectiles.h"
+#include "Counters.h"
+#include <math.h>
+
+ProjectileStore::ProjectileStore()
+{
+    bounds_min = glm::vec2(-1000.0f);
+    bounds_max = glm::vec2( 1000.0f);
+    
+    // Room for every projectile there can be, so spawning never reallocates mid-encounter
+    x.reserve(MAX_PROJECTILES);
+    y.reserve(MAX_PROJECTILES);
+    direction_x.reserve(MAX_PROJECTILES);
+    direction_y.reserve(MAX_PROJECTILES);
+    speed.reserve(MAX_PROJECTILES);
+    target_speed.reserve(MAX_PROJECTILES);
+    acceleration.reserve(MAX_PROJECTILES);
+    half_size.reserve(MAX_PROJECTILES);
+    texture_index.reserve(MAX_PROJECTILES);
+}
+
+void ProjectileStore::clear()
+{
+    x.clear();
+    y.clear();
+    direction_x.clear();
+    direction_y.clear();
+    speed.clear();
+    target_speed.clear();
+    acceleration.clear();
+    half_size.clear();
+    texture_index.clear();
+}
+
+int ProjectileStore::add_texture(GLuint texture_id)
+{
+    for (int i = 0; i < texture_count; i++) {
+        if (textures[i] == texture_id) return i;
+    }
+
+    if (texture_count == MAX_PROJECTILE_TEXTURES) return 0;
+
+    textures[texture_count] = texture_id;
+    return texture_count++;
+}
+
+bool ProjectileStore::spawn(glm::vec2 position, glm::vec2 direction, float speed, float target_speed, float acceleration,
+                            float size, int texture)
+{
+    if (this->size() >= MAX_PROJECTILES) return false;
+
+    x.push_back(position.x);
+    y.push_back(position.y);
+    direction_x.push_back(direction.x);
+    direction_y.push_back(direction.y);
+    this->speed.push_back(speed);
+    this->target_speed.push_back(target_speed);
+    this->acceleration.push_back(acceleration);
+    half_size.push_back(size / 2.0f);
+    texture_index.push_back((unsigned char) texture);
+
+    return true;
+}
+
+void ProjectileStore::remove(int index)
+{
+    // Order doesn't matter, so the last projectile takes the removed one's place
+    int last = size() - 1;
+
+    x[index]             = x[last];
+    y[index]             = y[last];
+    direction_x[index]   = direction_x[last];
+    direction_y[index]   = direction_y[last];
+    speed[index]         = speed[last];
+    target_speed[index]  = target_speed[last];
+    acceleration[index]  = acceleration[last];
+    half_size[index]     = half_size[last];
+    texture_index[index] = texture_index[last];
+
+    x.pop_back();
+    y.pop_back();
+    direction_x.pop_back();
+    direction_y.pop_back();
+    speed.pop_back();
+    target_speed.pop_back();
+    acceleration.pop_back();
+    half_size.pop_back();
+    texture_index.pop_back();
+}
+
+void ProjectileStore::integrate(float delta_time, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        // Speed curve: move towards the target speed without overshooting it
+        float change = acceleration[i] * delta_time;
+        if (speed[i] < target_speed[i]) speed[i] = fminf(speed[i] + change, target_speed[i]);
+        else                            speed[i] = fmaxf(speed[i] - change, target_speed[i]);
+
+        x[i] += direction_x[i] * speed[i] * delta_time;
+        y[i] += direction_y[i] * speed[i] * delta_time;
+    }
+}
+
+void ProjectileStore::update(float delta_time, JobSystem *jobs)
+{
+    int count = size();
+
+    if (jobs != nullptr) {
+        jobs->parallel_for(count, PROJECTILE_UPDATE_GRAIN, [&](int begin, int end) { integrate(delta_time, begin, end); });
+    } else {
+        integrate(delta_time, 0, count);
+    }
+
+    for (int i = size() - 1; i >= 0; i--)
+    {
+        if (x[i] < bounds_min.x || x[i] > bounds_max.x || y[i] < bounds_min.y || y[i] > bounds_max.y) remove(i);
+    }
+}
+
+bool const ProjectileStore::overlaps(glm::vec3 position, float width, float height) const
+{
+    int count = size();
+    COUNTER_ADD(COUNTER_COLLISION_TESTS, count);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (fabsf(position.x - x[i]) - (width  / 2.0f + half_size[i]) < 0.0f &&
+            fabsf(position.y - y[i]) - (height / 2.0f + half_size[i]) < 0.0f) return true;
+    }
+
+    return false;
+}
+
+void ProjectileStore::snapshot(RenderSnapshot *snapshot) const
+{
+    if (size() == 0) return;
+
+    // One batch per texture, however many projectiles use it
+    for (int t = 0; t < texture_count; t++)
+    {
+        BatchDraw &batch = snapshot->add_batch(textures[t]);
+
+        for (int i = 0; i < size(); i++)
+        {
+            if (texture_index[i] != t) continue;
+
+            float left = x[i] - half_size[i], right  = x[i] + half_size[i];
+            float top  = y[i] + half_size[i], bottom = y[i] - half_size[i];
+
+            batch.vertices.insert(batch.vertices.end(), {
+                left, bottom, right, bottom, right, top,
+                left, bottom, right, top,    left,  top
+            });
+
+            batch.texture_coordinates.insert(batch.texture_coordinates.end(), {
+                0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+                0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f
+            });
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "Snapshot.h"
+#include "Jobs.h"
+
+#define MAX_PROJECTILES 8192
+#define MAX_PROJECTILE_TEXTURES 8
+#define PROJECTILE_UPDATE_GRAIN 1024
+
+// Bullets without the weight of an Entity: no AI, no animation, no map collision.
+// Stored as structure-of-arrays so that moving and testing thousands of them stays cheap.
+class ProjectileStore {
+private:
+    std::vector<float> x, y;
+    std::vector<float> direction_x, direction_y;
+    std::vector<float> speed, target_speed, acceleration;
+    std::vector<float> half_size;
+    std::vector<unsigned char> texture_index;
+
+    GLuint textures[MAX_PROJECTILE_TEXTURES];
+    int texture_count = 0;
+
+    // Anything leaving this box is gone for good
+    glm::vec2 bounds_min, bounds_max;
+
+    void remove(int index);
+    void integrate(float delta_time, int begin, int end);
+
+public:
+    ProjectileStore();
+
+    void clear();
+    void set_bounds(glm::vec2 min, glm::vec2 max) { bounds_min = min; bounds_max = max; };
+    int add_texture(GLuint texture_id);
+
+    // Returns false when the store is full; speed eases towards target_speed at the given rate
+    bool spawn(glm::vec2 position, glm::vec2 direction, float speed, float target_speed, float acceleration,
+               float size, int texture);
+
+    // Movement runs across the job system when one is given; removals always happen on the calling thread
+    void update(float delta_time, JobSystem *jobs = nullptr);
+    bool const overlaps(glm::vec3 position, float width, float height) const;
+    void snapshot(RenderSnapshot *snapshot) const;
+
+    int const size() const { return (int) x.size(); };
+    // Everything the columns have room for
+    size_t const get_capacity_bytes() const { return x.capacity() * (8 * sizeof(float) + sizeof(unsigned char)); };
+    glm::vec2 const get_position(int index) const { return glm::vec2(x[index], y[index]); };
+};
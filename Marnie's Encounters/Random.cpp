@@ -0,0 +1,139 @@
+#include "Random.h"
+
+static inline uint32_t rotl(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+// splitmix64, the usual way of spreading one 64-bit seed over a bigger state
+static uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Top 24 bits as a float in [0, 1), every value exactly representable
+static inline float to_unit_float(uint32_t x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+void Rng::seed(uint64_t seed)
+{
+    uint64_t a = splitmix64(seed);
+    uint64_t b = splitmix64(seed);
+
+    state[0] = (uint32_t) a;
+    state[1] = (uint32_t) (a >> 32);
+    state[2] = (uint32_t) b;
+    state[3] = (uint32_t) (b >> 32);
+}
+
+uint32_t Rng::next()
+{
+    uint32_t result = rotl(state[1] * 5, 7) * 9;
+    uint32_t t = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 11);
+
+    return result;
+}
+
+float Rng::next_float()
+{
+    return to_unit_float(next());
+}
+
+float Rng::range(float a, float b)
+{
+    return a + (b - a) * next_float();
+}
+
+void Rng::jump()
+{
+    static const uint32_t JUMP[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int b = 0; b < 32; b++)
+        {
+            if (JUMP[i] & (1u << b))
+            {
+                s0 ^= state[0];
+                s1 ^= state[1];
+                s2 ^= state[2];
+                s3 ^= state[3];
+            }
+            next();
+        }
+    }
+
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+}
+
+void RngBulk::seed(uint64_t seed)
+{
+    Rng source;
+    source.seed(seed);
+    this->seed(source);
+}
+
+void RngBulk::seed(Rng &source)
+{
+    for (int l = 0; l < RNG_BULK_LANES; l++)
+    {
+        for (int j = 0; j < 4; j++) state[j][l] = source.state[j];
+        source.jump();
+    }
+}
+
+void RngBulk::fill(float *out, int count, float a, float b)
+{
+    float scale = b - a;
+    uint32_t results[RNG_BULK_LANES];
+
+    for (int i = 0; i < count; i += RNG_BULK_LANES)
+    {
+        // Same steps as Rng::next, once per lane; no branches, so this loop vectorises
+        for (int l = 0; l < RNG_BULK_LANES; l++)
+        {
+            results[l] = rotl(state[1][l] * 5, 7) * 9;
+            uint32_t t = state[1][l] << 9;
+
+            state[2][l] ^= state[0][l];
+            state[3][l] ^= state[1][l];
+            state[1][l] ^= state[2][l];
+            state[0][l] ^= state[3][l];
+            state[2][l] ^= t;
+            state[3][l] = rotl(state[3][l], 11);
+        }
+
+        int n = count - i < RNG_BULK_LANES ? count - i : RNG_BULK_LANES;
+        for (int l = 0; l < n; l++) out[i + l] = a + scale * to_unit_float(results[l]);
+    }
+}
+
+void RandomService::seed(uint64_t seed)
+{
+    Rng base;
+    base.seed(seed);
+
+    // Every stream, and every lane of every bulk stream, is its own stretch of one sequence
+    for (int i = 0; i < RNG_STREAM_COUNT; i++)
+    {
+        streams[i] = base;
+        base.jump();
+        bulk_streams[i].seed(base);
+    }
+}
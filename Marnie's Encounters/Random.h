@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+// Lanes of RngBulk; eight 32-bit lanes fill one AVX register, or two SSE ones
+#define RNG_BULK_LANES 8
+
+// xoshiro128**: four words of state, a handful of shifts per number, and far better output than rand()
+class Rng {
+    friend class RngBulk;
+
+    uint32_t state[4];
+
+public:
+    Rng() { seed(0); }
+
+    void seed(uint64_t seed);
+    uint32_t next();
+    float next_float();                 // [0, 1)
+    float range(float a, float b);      // [a, b)
+
+    // Skips 2^64 numbers ahead; successive jumps hand out streams that never overlap
+    void jump();
+};
+
+// RNG_BULK_LANES xoshiro128** generators stepped together, for filling whole arrays at once.
+// The lanes are kept as structure-of-arrays so the compiler can turn each step into vector instructions.
+class RngBulk {
+    uint32_t state[4][RNG_BULK_LANES];
+
+public:
+    RngBulk() { seed(0); }
+
+    void seed(uint64_t seed);
+
+    // Takes RNG_BULK_LANES consecutive jumps of source as its lanes, leaving source past all of them
+    void seed(Rng &source);
+
+    void fill(float *out, int count, float a, float b);
+};
+
+// Independent streams, so that (say) a screen shake never changes where the next bullet spawns
+enum RngStream { RNG_SPAWNER, RNG_EFFECTS, RNG_AI, RNG_STREAM_COUNT };
+
+class RandomService {
+    Rng streams[RNG_STREAM_COUNT];
+    RngBulk bulk_streams[RNG_STREAM_COUNT];
+
+public:
+    void seed(uint64_t seed);
+
+    Rng     &stream(RngStream stream) { return streams[stream];      };
+    RngBulk &bulk(RngStream stream)   { return bulk_streams[stream]; };
+};
@@ -0,0 +1,95 @@
+#include "RegionLoader.h"
+#include "Level.h"
+#include "Profiler.h"
+#include <algorithm>
+
+RegionLoader::RegionLoader(const char *index_path)
+{
+    this->index_path = index_path;
+    this->thread = std::thread(&RegionLoader::loop, this);
+}
+
+RegionLoader::~RegionLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    this->thread.join();
+
+    for (size_t i = 0; i < this->ready.size(); i++) delete this->ready[i].second;
+}
+
+void RegionLoader::loop()
+{
+    PROFILE_THREAD("region loader");
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true)
+    {
+        this->wake.wait(lock, [&] { return this->stopping || !this->requests.empty(); });
+        if (this->stopping) return;
+
+        this->loading = this->requests.front();
+        this->requests.erase(this->requests.begin());
+        std::string path = Level::region_path(this->index_path.c_str(), this->loading);
+
+        lock.unlock();
+        Level *level;
+        {
+            PROFILE_ZONE("open region");
+            level = new Level(path.c_str());
+            if (level->is_valid()) level->touch();
+        }
+        lock.lock();
+
+        this->ready.push_back(std::make_pair(this->loading, level));
+        this->loading = -1;
+        this->opened.notify_all();
+    }
+}
+
+void RegionLoader::request(int region)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->loading == region) return;
+    if (std::find(this->requests.begin(), this->requests.end(), region) != this->requests.end()) return;
+    for (size_t i = 0; i < this->ready.size(); i++) if (this->ready[i].first == region) return;
+
+    this->requests.push_back(region);
+    this->wake.notify_one();
+}
+
+Level *RegionLoader::take(int region)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    // Half-opened already: finishing it is quicker than starting again
+    this->opened.wait(lock, [&] { return this->loading != region; });
+
+    for (size_t i = 0; i < this->ready.size(); i++)
+    {
+        if (this->ready[i].first != region) continue;
+
+        Level *level = this->ready[i].second;
+        this->ready.erase(this->ready.begin() + i);
+        return level;
+    }
+
+    this->requests.erase(std::remove(this->requests.begin(), this->requests.end(), region), this->requests.end());
+    return nullptr;
+}
+
+bool RegionLoader::take_any(int *region, Level **level)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->ready.empty()) return false;
+
+    *region = this->ready.back().first;
+    *level = this->ready.back().second;
+    this->ready.pop_back();
+    return true;
+}
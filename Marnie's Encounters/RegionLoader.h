@@ -0,0 +1,45 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class Level;
+
+// Opens the regions of a streamed map on a thread of its own and reads them in, so that by the time
+// the simulation needs one it is usually mapped and paged in already. It is only ever a head start:
+// the simulation opens anything it needs that isn't ready itself, so nothing depends on how far this has got.
+class RegionLoader {
+    std::string index_path;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable opened;
+
+    std::vector<int> requests;                  // Oldest first
+    int loading = -1;                           // The region being opened right now, if any
+    std::vector<std::pair<int, Level*>> ready;  // Opened and waiting to be taken
+    bool stopping = false;
+
+    void loop();
+
+public:
+    RegionLoader(const char *index_path);
+    ~RegionLoader();
+
+    RegionLoader(const RegionLoader&) = delete;
+    RegionLoader &operator=(const RegionLoader&) = delete;
+
+    // Queues a region, unless it is already queued, being opened or waiting to be taken
+    void request(int region);
+
+    // The region if it is ready, after waiting for it if it is being opened right now. Otherwise null,
+    // and the region is dropped from the queue so that the caller can open it itself.
+    Level *take(int region);
+
+    // Anything opened that nobody has asked for yet; false when there's nothing
+    bool take_any(int *region, Level **level);
+};
@@ -0,0 +1,403 @@
+#define LOG(argument) std::cout << argument << '\n'
+
+#include "Resources.h"
+#include "stb_image.h"
+#include "Memory.h"
+#include "ShaderProgram.h"
+#include "Jobs.h"
+#include "Profiler.h"
+#include "Allocations.h"
+#include <iostream>
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+
+DeviceResources::DeviceResources(JobSystem *jobs)
+{
+    this->jobs = jobs;
+    this->gl_thread = std::this_thread::get_id();
+    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
+}
+
+DeviceResources::~DeviceResources()
+{
+    // Textures go with the GL context; the audio has to be handed back by hand
+    for (auto &sound : sounds) Mix_FreeChunk(sound.second);
+    for (auto &music : musics) Mix_FreeMusic(music.second);
+
+    Mix_CloseAudio();
+}
+
+// Copies texels into the next pixel buffer and leaves it bound, so the glTexImage2D that follows reads
+// from there (at offset 0) and the driver can carry on with the transfer after the call returns
+const void *DeviceResources::stage(const void *texels, size_t size)
+{
+    GLuint &buffer = this->upload_buffers[this->next_upload_buffer];
+    this->next_upload_buffer = (this->next_upload_buffer + 1) % UPLOAD_BUFFER_COUNT;
+
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+
+    // Respecifying the storage orphans whatever an earlier upload may still be reading
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void *mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+
+    if (mapped == NULL)
+    {
+        // Nothing staged; the upload reads straight from memory instead
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return texels;
+    }
+
+    memcpy(mapped, texels, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    return NULL;
+}
+
+GLuint DeviceResources::upload(PendingUpload *request)
+{
+    // Other threads hand their images over through queue_upload()
+    assert(std::this_thread::get_id() == this->gl_thread);
+
+    GLuint texture_id = request->texture_id;
+    if (texture_id == 0) glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    const CompactImage *image = request->image;
+    const void *texels = stage(image->texels.data(), image->texels.size());
+
+    // Rows of one- and two-byte texels needn't come to a multiple of four
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    switch (image->format)
+    {
+        case TEXELS_PALETTED:
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, image->width, image->height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, texels);
+            break;
+        case TEXELS_RGBA4444:
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA4, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, texels);
+            break;
+        case TEXELS_RGB5A1:
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB5_A1, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, texels);
+            break;
+        default:
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+            break;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Crisp pixels, tiling allowed, as textures have always been loaded here. Nearest
+    // filtering is also what keeps palette indices from being blended into ones that mean nothing.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    if (image->format == TEXELS_PALETTED)
+    {
+        GLuint palette_id;
+        glGenTextures(1, &palette_id);
+        glBindTexture(GL_TEXTURE_2D, palette_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PALETTE_SIZE, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->palette);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        if (this->texture_palettes.size() <= texture_id) this->texture_palettes.resize(texture_id + 1, 0);
+        this->texture_palettes[texture_id] = palette_id;
+    }
+
+    return texture_id;
+}
+
+void DeviceResources::upload_luminance_now(PendingLuminance *request)
+{
+    // Whatever the region holds now decides; the simulation may have baked again, or closed it, since asking
+    GLuint texture_id = request->texture_id->load();
+    GLuint spare_id = request->spare_id;
+    bool refill = texture_id != 0;
+
+    if (texture_id == 0 && spare_id != 0) std::swap(texture_id, spare_id);
+    if (spare_id != 0) release_texture(spare_id);
+
+    if (texture_id == 0)
+    {
+        glGenTextures(1, &texture_id);
+
+        // A new lightmap means the simulation opened a region; its charge is booked here, on the render thread
+        ALLOC_WARM_UP();
+
+        // Refills are assumed to keep the size they were made with; only new textures are counted
+        TextureCharge charge = { MEMORY_LIGHTMAPS, request->owner, (int64_t) request->width * request->height };
+        Memory::add(charge.kind, charge.owner, charge.bytes);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->charges[texture_id] = charge;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, request->width, request->height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, request->texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Linear filtering hides the texel grid; clamping keeps sprites past the edge lit like the edge
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Only this thread ever stores a texture. The simulation can only take one back, by storing 0, which leaves
+    // a refilled texture as its spare; a new one goes in regardless, and comes back when the region goes.
+    if (!refill) request->texture_id->store(texture_id);
+}
+
+void DeviceResources::bind_texture(ShaderProgram *program, GLuint texture_id)
+{
+    GLuint palette_id = texture_id < this->texture_palettes.size() ? this->texture_palettes[texture_id] : 0;
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    program->paletteUniforms.paletted.Set(palette_id != 0);
+
+    if (palette_id != 0)
+    {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, palette_id);
+        glActiveTexture(GL_TEXTURE0);
+    }
+}
+
+void DeviceResources::service()
+{
+    std::vector<PendingUpload*> requests;
+    std::vector<PendingLuminance> luminance;
+    std::vector<GLuint> releases;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->pending.empty() && this->pending_luminance.empty() && this->pending_releases.empty()) return;
+        requests.swap(this->pending);
+        luminance.swap(this->pending_luminance);
+        releases.swap(this->pending_releases);
+    }
+
+    if (!releases.empty()) glDeleteTextures((GLsizei) releases.size(), releases.data());
+
+    // Letting go of keep_alive may free what it kept, which can release textures, so that's done without the lock too
+    for (size_t i = 0; i < luminance.size(); i++) upload_luminance_now(&luminance[i]);
+    luminance.clear();
+
+    if (requests.empty()) return;
+
+    // Without the lock, so decoders can keep queueing images while these go up
+    for (PendingUpload *request : requests) request->texture_id = upload(request);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (PendingUpload *request : requests) request->done = true;
+    this->uploaded.notify_all();
+}
+
+void DeviceResources::queue_upload(PendingUpload *request)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->pending.push_back(request);
+    this->queued.notify_all();
+}
+
+void DeviceResources::wait_for_uploads(PendingUpload *requests, int count)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    auto all_done = [&] {
+        for (int i = 0; i < count; i++) if (!requests[i].done) return false;
+        return true;
+    };
+
+    if (std::this_thread::get_id() != this->gl_thread)
+    {
+        this->uploaded.wait(lock, all_done);
+        return;
+    }
+
+    // The GL thread does the uploads itself, each as soon as its image turns up
+    while (!all_done())
+    {
+        this->queued.wait(lock, [&] { return !this->pending.empty(); });
+
+        lock.unlock();
+        service();
+        lock.lock();
+    }
+}
+
+// Decoding is the slow part. Images are also packed where they're decoded, so the GL thread only has
+// the smaller upload to do.
+static void decode_image(const char *filepath, CompactImage *out)
+{
+    PROFILE_ZONE("decode_image");
+
+    int width, height, number_of_components;
+    unsigned char *image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
+
+    if (image == NULL)
+    {
+        LOG("Unable to load image " << filepath << ". Make sure the path is correct.");
+        assert(false);
+
+        // Drawn as nothing rather than not at all
+        const unsigned char transparent[4] = { 0, 0, 0, 0 };
+        compact_image(transparent, 1, 1, out);
+        return;
+    }
+
+    compact_image(image, width, height, out);
+    stbi_image_free(image);
+}
+
+GLuint DeviceResources::texture(const char *filepath)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto found = textures.find(filepath);
+        if (found != textures.end()) return found->second;
+    }
+
+    preload_textures(&filepath, 1);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return textures[filepath];
+}
+
+void DeviceResources::preload_textures(const char *const *filepaths, int count)
+{
+    PROFILE_ZONE("preload_textures");
+
+    // Only what isn't loaded yet, each path once
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (int i = 0; i < count; i++)
+        {
+            if (textures.count(filepaths[i]) != 0) continue;
+            if (std::find(paths.begin(), paths.end(), filepaths[i]) == paths.end()) paths.push_back(filepaths[i]);
+        }
+    }
+
+    int image_count = (int) paths.size();
+    if (image_count == 0) return;
+
+    std::vector<CompactImage> images(image_count);
+    // Filled in before decoding starts, since the GL thread reads them while the decoders run
+    std::vector<PendingUpload> requests(image_count);
+    for (int i = 0; i < image_count; i++) requests[i] = { 0, &images[i], false };
+
+    std::function<void(int, int)> decode = [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            decode_image(paths[i].c_str(), &images[i]);
+            queue_upload(&requests[i]);
+        }
+    };
+
+    // Off the GL thread, the caller decodes alongside the pool and the GL thread uploads as they come.
+    // On it, the pool decodes from another thread, leaving this one free to upload.
+    std::thread decoder;
+    if (std::this_thread::get_id() != this->gl_thread) this->jobs->parallel_for(image_count, 1, decode);
+    else if (image_count == 1) decode(0, 1);
+    else decoder = std::thread([&] { this->jobs->parallel_for(image_count, 1, decode); });
+
+    wait_for_uploads(requests.data(), image_count);
+    if (decoder.joinable()) decoder.join();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (int i = 0; i < image_count; i++)
+    {
+        textures[paths[i]] = requests[i].texture_id;
+        Memory::add(MEMORY_TEXTURES, Memory::current_owner(), compact_image_bytes(images[i]));
+    }
+}
+
+void DeviceResources::upload_luminance(std::atomic<GLuint> *texture_id, GLuint spare_id, std::vector<unsigned char> &&texels, int width, int height,
+                                       std::shared_ptr<const void> keep_alive)
+{
+    // Queued even on the GL thread, which services every frame; nobody waits, so it makes no difference
+    PendingLuminance request;
+    request.texture_id = texture_id;
+    request.spare_id = spare_id;
+    request.texels = std::move(texels);
+    request.width = width;
+    request.height = height;
+    request.owner = Memory::current_owner();
+    request.keep_alive = std::move(keep_alive);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->pending_luminance.push_back(std::move(request));
+}
+
+void DeviceResources::release_texture(GLuint texture_id)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        auto charge = this->charges.find(texture_id);
+        if (charge != this->charges.end())
+        {
+            Memory::add(charge->second.kind, charge->second.owner, -charge->second.bytes);
+            this->charges.erase(charge);
+        }
+
+        if (std::this_thread::get_id() != this->gl_thread)
+        {
+            this->pending_releases.push_back(texture_id);
+            return;
+        }
+    }
+
+    glDeleteTextures(1, &texture_id);
+}
+
+Mix_Chunk *DeviceResources::sound(const char *filepath)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto found = sounds.find(filepath);
+    if (found != sounds.end()) return found->second;
+
+    Mix_Chunk *chunk = Mix_LoadWAV(filepath);
+    sounds[filepath] = chunk;
+    if (chunk != nullptr) Memory::add(MEMORY_AUDIO, Memory::current_owner(), chunk->alen);
+    return chunk;
+}
+
+Mix_Music *DeviceResources::music(const char *filepath)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto found = musics.find(filepath);
+    if (found != musics.end()) return found->second;
+
+    Mix_Music *music = Mix_LoadMUS(filepath);
+    musics[filepath] = music;
+    return music;
+}
+
+void DeviceResources::play_sound(Mix_Chunk *chunk)
+{
+    if (chunk != nullptr) Mix_PlayChannel(-1, chunk, 0);
+}
+
+void DeviceResources::play_music(Mix_Music *music)
+{
+    if (music != nullptr) Mix_PlayMusic(music, -1);
+}
+
+void DeviceResources::set_music_volume(int volume)
+{
+    Mix_VolumeMusic(volume);
+}
+
+void DeviceResources::halt_music()
+{
+    Mix_HaltMusic();
+}
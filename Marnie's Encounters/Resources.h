@@ -0,0 +1,168 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <map>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <SDL_mixer.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "TextureFormat.h"
+#include "Memory.h"
+
+class ShaderProgram;
+class JobSystem;
+
+// Pixel buffers uploads are staged through in turn, so filling one never waits on the last upload
+#define UPLOAD_BUFFER_COUNT 3
+
+// Everything a scene needs from the GPU and the sound card, handed to it instead of reached for.
+// Scenes never load or play anything themselves, so the same scene code runs with or without a device.
+class Resources {
+public:
+    virtual ~Resources() {};
+
+    // Loaded once per path; the same id comes back every time after that
+    virtual GLuint texture(const char *filepath) = 0;
+
+    // Loads every one of these that isn't loaded yet, all at once, so texture() finds them ready
+    virtual void preload_textures(const char *const *filepaths, int count) = 0;
+
+    // Fills the single-channel texture whose id is in *texture_id without waiting for it: the GL thread does it
+    // the next time it services. If *texture_id is still 0 by then it gets spare_id, or else a new texture, and
+    // the id is stored there; until then, whoever reads it sees 0 and draws without. Setting *texture_id to 0
+    // in the meantime takes the texture back from it, and it is filled but not stored. keep_alive is held until
+    // then, so whatever *texture_id lives in can't go away first. A spare that isn't needed is released.
+    virtual void upload_luminance(std::atomic<GLuint> *texture_id, GLuint spare_id, std::vector<unsigned char> &&texels, int width, int height,
+                                  std::shared_ptr<const void> keep_alive) = 0;
+
+    // Frees a texture made by upload_luminance and takes it off the memory report. Any thread may; off the
+    // GL thread, the texture goes the next time that thread services, so no frame in flight loses it.
+    virtual void release_texture(GLuint texture_id) = 0;
+
+    virtual Mix_Chunk *sound(const char *filepath) = 0;
+    virtual Mix_Music *music(const char *filepath) = 0;
+
+    virtual void play_sound(Mix_Chunk *chunk) = 0;
+    virtual void play_music(Mix_Music *music) = 0;
+    virtual void set_music_volume(int volume) = 0;
+    virtual void halt_music() = 0;
+
+    // GL thread only: binds a texture to unit 0 for program, and its palette to unit 2 if it has one.
+    // Every texture drawn through the lit or textured shaders should be bound through here.
+    virtual void bind_texture(ShaderProgram *program, GLuint texture_id) = 0;
+};
+
+// An image upload asked for by a thread that doesn't own the GL context, which waits for it
+struct PendingUpload
+{
+    GLuint texture_id;
+    const CompactImage *image;
+    bool done;
+};
+
+// A single-channel upload nobody waits for; see Resources::upload_luminance
+struct PendingLuminance
+{
+    std::atomic<GLuint> *texture_id;
+    GLuint spare_id;
+    std::vector<unsigned char> texels;
+    int width, height;
+    const char *owner;      // Who a new texture is charged to
+    std::shared_ptr<const void> keep_alive;
+};
+
+// Who a texture's memory was charged to, so releasing it can take the same amount back
+struct TextureCharge
+{
+    MemoryKind kind;
+    const char *owner;
+    int64_t bytes;
+};
+
+// The real thing: needs a current GL context, and opens the audio device for as long as it lives.
+// Any thread may ask for textures. Images are decoded on the job system, each handed to the thread that
+// created this as soon as it is decoded, and uploaded there by service() through a pixel buffer; the
+// caller waits until the last is up. On the GL thread itself, that thread uploads while the pool decodes.
+// Lightmaps go through service() too, but nobody waits for them.
+class DeviceResources : public Resources {
+    std::map<std::string, GLuint> textures;
+    std::map<std::string, Mix_Chunk*> sounds;
+    std::map<std::string, Mix_Music*> musics;
+
+    JobSystem *jobs;
+
+    std::thread::id gl_thread;
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable uploaded;
+    std::vector<PendingUpload*> pending;
+    std::vector<PendingLuminance> pending_luminance;
+    std::vector<GLuint> pending_releases;
+    std::map<GLuint, TextureCharge> charges;
+
+    // GL thread only
+    GLuint upload_buffers[UPLOAD_BUFFER_COUNT] = { 0 };
+    int next_upload_buffer = 0;
+    std::vector<GLuint> texture_palettes;   // By texture id: the palette of a paletted texture, 0 for the rest
+
+    GLuint upload(PendingUpload *request);
+    void upload_luminance_now(PendingLuminance *request);
+    const void *stage(const void *texels, size_t size);
+    void queue_upload(PendingUpload *request);
+    void wait_for_uploads(PendingUpload *requests, int count);
+
+public:
+    DeviceResources(JobSystem *jobs);
+    ~DeviceResources();
+
+    // GL thread only: performs every upload other threads asked for, and frees what they released
+    void service();
+
+    GLuint texture(const char *filepath) override;
+    void preload_textures(const char *const *filepaths, int count) override;
+    void upload_luminance(std::atomic<GLuint> *texture_id, GLuint spare_id, std::vector<unsigned char> &&texels, int width, int height,
+                          std::shared_ptr<const void> keep_alive) override;
+    void release_texture(GLuint texture_id) override;
+
+    Mix_Chunk *sound(const char *filepath) override;
+    Mix_Music *music(const char *filepath) override;
+
+    void play_sound(Mix_Chunk *chunk) override;
+    void play_music(Mix_Music *music) override;
+    void set_music_volume(int volume) override;
+    void halt_music() override;
+
+    void bind_texture(ShaderProgram *program, GLuint texture_id) override;
+};
+
+// For simulations nobody watches or hears: loads nothing, plays nothing, and holds no state,
+// so any number of threads can share one
+class NullResources : public Resources {
+public:
+    GLuint texture(const char * /*filepath*/) override { return 0; };
+    void preload_textures(const char *const * /*filepaths*/, int /*count*/) override {};
+    void upload_luminance(std::atomic<GLuint> * /*texture_id*/, GLuint /*spare_id*/, std::vector<unsigned char> && /*texels*/, int /*width*/, int /*height*/,
+                          std::shared_ptr<const void> /*keep_alive*/) override {};
+    void release_texture(GLuint /*texture_id*/) override {};
+
+    Mix_Chunk *sound(const char * /*filepath*/) override { return nullptr; };
+    Mix_Music *music(const char * /*filepath*/) override { return nullptr; };
+
+    void play_sound(Mix_Chunk * /*chunk*/) override {};
+    void play_music(Mix_Music * /*music*/) override {};
+    void set_music_volume(int /*volume*/) override {};
+    void halt_music() override {};
+
+    void bind_texture(ShaderProgram * /*program*/, GLuint /*texture_id*/) override {};
+};
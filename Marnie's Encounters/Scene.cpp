@@ -1 +1,37 @@
 #include "Scene.h"
+#include "Memory.h"
+
+void Scene::unload()
+{
+    // Nothing may point into the arena once it is released
+    this->state.map = nullptr;
+    this->state.player = nullptr;
+    this->state.enemies = nullptr;
+    this->state.vec_enemies.clear();
+
+    this->arena.release();
+}
+
+glm::vec3 const Scene::player_spawn() const
+{
+    const Level *level = this->state.map->get_level();
+
+    for (int i = 0; i < level->get_spawn_count(); i++)
+    {
+        const LevelSpawn &spawn = level->get_spawn(i);
+        if (spawn.type == SPAWN_PLAYER) return glm::vec3(spawn.x, spawn.y, 0.0f);
+    }
+
+    return glm::vec3(0.0f);
+}
+
+void Scene::account_memory() const
+{
+    // Entities in the arena are taken out of its figure, so nothing is counted twice
+    size_t arena_entity_bytes = sizeof(Entity) * arena_entity_count();
+    size_t entity_bytes = arena_entity_bytes + this->state.vec_enemies.capacity() * sizeof(Entity*) + other_entity_bytes();
+
+    Memory::set(MEMORY_MAP_GEOMETRY, this->name, this->state.map != nullptr ? this->state.map->get_geometry_bytes() : 0);
+    Memory::set(MEMORY_ENTITIES, this->name, entity_bytes);
+    Memory::set(MEMORY_ARENAS, this->name, this->arena.get_capacity() - arena_entity_bytes);
+}
@@ -15,21 +15,34 @@
 #include "Utility.h"
 #include "Entity.h"
 #include "Map.h"
+#include "Lighting.h"
+#include "Random.h"
+#include "Resources.h"
+#include "Jobs.h"
+#include "Snapshot.h"
+#include "Arena.h"
 #include <vector>
 
 struct GameState
 {
-    Map *map;
-    Entity *player;
-    Entity *enemies;
+    Map *map = nullptr;
+    Entity *player = nullptr;
+    Entity *enemies = nullptr;
     std::vector<Entity*> vec_enemies;
     
-    Mix_Music *bgm;
-    Mix_Chunk *jump_sfx;
-    Mix_Chunk* win_sfx;
-    Mix_Chunk* lose_sfx;
+    // Owned by resources; scenes that never load a sound leave theirs null
+    Mix_Music *bgm = nullptr;
+    Mix_Chunk *jump_sfx = nullptr;
+    Mix_Chunk* win_sfx = nullptr;
+    Mix_Chunk* lose_sfx = nullptr;
     
-    int next_scene_id;
+    // Owned by the Game, handed to every scene before it is initialised
+    Lighting *lighting = nullptr;
+    RandomService *random = nullptr;
+    Resources *resources = nullptr;
+    JobSystem *jobs = nullptr;
+    
+    int next_scene_id = -1;
 };
 
 class Scene {
@@ -38,9 +51,38 @@ public:
     
     GameState state;
     
+    // The scene's line in the memory report, and what it is charged with loading
+    const char *name = "scene";
+    
+    // Owns the map, the entities and their animation tables from initialise() until unload()
+    Arena arena;
+    
+    virtual ~Scene() {}
+    
     virtual void initialise() = 0;
+    // Lets go of everything initialise() made, all at once; the scene can be initialised again afterwards
+    virtual void unload();
     virtual void update(float delta_time) = 0;
-    virtual void render(ShaderProgram *program) = 0;
+    // Copies out what to draw; runs on the simulation thread, so it must only read scene state
+    virtual void snapshot(RenderSnapshot *snapshot) = 0;
+    
+    // Called once per frame before rendering; scenes add whatever glows this frame
+    virtual void add_lights(Lighting * /*lighting*/) {}
+    
+    // True when the picture only changes on a scene change, so the renderer can stop redrawing it
+    virtual bool const is_static() const { return false; }
+
+    // Where the level's player spawn is; the origin if it doesn't have one
+    glm::vec3 const player_spawn() const;
+
+    virtual int live_entity_count() const { return 1 + (int) state.vec_enemies.size(); }
+    
+    // Entities made in the arena, and the bytes of any kept outside it; see account_memory
+    virtual int arena_entity_count() const { return state.player != nullptr ? 1 + (int) state.vec_enemies.size() : 0; }
+    virtual size_t other_entity_bytes() const { return 0; }
+    
+    // Brings this scene's figures in the memory report up to date
+    void account_memory() const;
     
     GameState const get_state() const { return this->state; }
 };
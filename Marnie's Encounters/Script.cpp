@@ -0,0 +1,90 @@
+#include "Script.h"
+#include <exception>
+
+void ScriptTask::promise_type::unhandled_exception()
+{
+    // Nothing in the game throws; if a script does, there is no sensible way to carry on
+    std::terminate();
+}
+
+ScriptTask::~ScriptTask()
+{
+    // Only a task that was never started still owns its coroutine
+    if (handle) handle.destroy();
+}
+
+void ScriptWait::await_suspend(std::coroutine_handle<ScriptTask::promise_type> handle) const
+{
+    Timeline *timeline = handle.promise().timeline;
+
+    float wake_time = until_phase_end ? timeline->get_phase_end_time() : timeline->get_time() + duration;
+    timeline->sleep(handle, wake_time);
+}
+
+Timeline::~Timeline()
+{
+    clear();
+}
+
+void Timeline::start(ScriptTask task)
+{
+    std::coroutine_handle<ScriptTask::promise_type> handle = task.handle;
+    task.handle = nullptr;
+
+    handle.promise().timeline = this;
+    scripts.push_back(handle);
+    resume(handle);
+}
+
+void Timeline::sleep(std::coroutine_handle<ScriptTask::promise_type> handle, float wake_time)
+{
+    ScriptWake wake;
+    wake.time = wake_time;
+    wake.order = next_order++;
+    wake.handle = handle;
+
+    sleeping.push(wake);
+}
+
+void Timeline::resume(std::coroutine_handle<ScriptTask::promise_type> handle)
+{
+    handle.resume();
+    if (!handle.done()) return;
+
+    // Finished scripts are freed straight away
+    for (size_t i = 0; i < scripts.size(); i++)
+    {
+        if (scripts[i] == handle)
+        {
+            scripts[i] = scripts.back();
+            scripts.pop_back();
+            break;
+        }
+    }
+    handle.destroy();
+}
+
+void Timeline::clear()
+{
+    while (!sleeping.empty()) sleeping.pop();
+
+    for (size_t i = 0; i < scripts.size(); i++) scripts[i].destroy();
+    scripts.clear();
+
+    time = 0.0f;
+    phase_end_time = 0.0f;
+    next_order = 0;
+}
+
+void Timeline::update(float delta_time)
+{
+    time += delta_time;
+
+    // A resumed script may go back to sleep already due (seconds(0)); it then runs again this step
+    while (!sleeping.empty() && sleeping.top().time <= time)
+    {
+        std::coroutine_handle<ScriptTask::promise_type> handle = sleeping.top().handle;
+        sleeping.pop();
+        resume(handle);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <coroutine>
+#include <queue>
+#include <vector>
+
+class Timeline;
+
+// A scene script: a coroutine that waits on its Timeline instead of checking the clock every step.
+// Scripts start suspended; Timeline::start() owns them from then on.
+class ScriptTask {
+public:
+    struct promise_type
+    {
+        Timeline *timeline = nullptr;
+
+        ScriptTask get_return_object() { return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this)); };
+        std::suspend_always initial_suspend() noexcept { return {}; };
+        std::suspend_always final_suspend() noexcept { return {}; };
+        void return_void() {};
+        void unhandled_exception();
+    };
+
+    explicit ScriptTask(std::coroutine_handle<promise_type> handle) : handle(handle) {};
+    ScriptTask(ScriptTask &&other) noexcept : handle(other.handle) { other.handle = nullptr; };
+    ScriptTask(const ScriptTask &) = delete;
+    ~ScriptTask();
+
+private:
+    friend class Timeline;
+    std::coroutine_handle<promise_type> handle;
+};
+
+// What co_await seconds(...) and co_await phase_end() hand to the timeline
+struct ScriptWait
+{
+    float duration;
+    bool until_phase_end;
+
+    bool await_ready() const noexcept { return false; };
+    void await_suspend(std::coroutine_handle<ScriptTask::promise_type> handle) const;
+    void await_resume() const noexcept {};
+};
+
+inline ScriptWait seconds(float duration) { return ScriptWait { duration, false }; }
+inline ScriptWait phase_end()             { return ScriptWait { 0.0f, true }; }
+
+struct ScriptWake
+{
+    float time;
+    unsigned int order;     // Breaks ties so scripts due together resume in the order they slept
+    std::coroutine_handle<ScriptTask::promise_type> handle;
+
+    bool operator>(const ScriptWake &other) const
+    {
+        return time > other.time || (time == other.time && order > other.order);
+    };
+};
+
+// Resumes sleeping scripts when their time comes. Only the earliest wake-up is looked at each step,
+// so a script waiting out a long phase costs nothing until it is due.
+class Timeline {
+    std::priority_queue<ScriptWake, std::vector<ScriptWake>, std::greater<ScriptWake>> sleeping;
+    std::vector<std::coroutine_handle<ScriptTask::promise_type>> scripts;
+    unsigned int next_order = 0;
+
+    float time = 0.0f;
+    float phase_end_time = 0.0f;
+
+    void resume(std::coroutine_handle<ScriptTask::promise_type> handle);
+
+public:
+    ~Timeline();
+
+    // Runs the script up to its first co_await
+    void start(ScriptTask task);
+    void sleep(std::coroutine_handle<ScriptTask::promise_type> handle, float wake_time);
+    void clear();
+
+    void update(float delta_time);
+
+    // phase_end() resumes once this many seconds have passed since the call
+    void begin_phase(float length) { phase_end_time = time + length; };
+
+    float const get_time() const { return time; };
+    float const get_phase_end_time() const { return phase_end_time; };
+    bool const is_idle() const { return scripts.empty(); };
+};
@@ -2,12 +2,41 @@
 
 #include "ShaderProgram.h"
 
-void ShaderProgram::Load(const char *vertexShaderFile, const char *fragmentShaderFile) {
+#include <map>
+#include <tuple>
+
+typedef std::tuple<ShaderSource, ShaderSource, std::string> ProgramKey;
+
+// Every program built so far
+static std::map<ProgramKey, ShaderProgram *> programs;
+
+ShaderProgram *ShaderProgram::Get(ShaderSource vertexSource, ShaderSource fragmentSource, const std::string &defines) {
+    ProgramKey key(vertexSource, fragmentSource, defines);
+
+    auto found = programs.find(key);
+    if (found != programs.end()) return found->second;
+
+    ShaderProgram *program = new ShaderProgram();
+    program->Load(vertexSource, fragmentSource, defines);
+    programs[key] = program;
+
+    return program;
+}
+
+void ShaderProgram::CleanupAll() {
+    for (auto &entry : programs) {
+        entry.second->Cleanup();
+        delete entry.second;
+    }
+    programs.clear();
+}
+
+void ShaderProgram::Load(ShaderSource vertexSource, ShaderSource fragmentSource, const std::string &defines) {
     
     // create the vertex shader
-    vertexShader = LoadShaderFromFile(vertexShaderFile, GL_VERTEX_SHADER);
+    vertexShader = LoadShader(vertexSource, defines, GL_VERTEX_SHADER);
     // create the fragment shader
-    fragmentShader = LoadShaderFromFile(fragmentShaderFile, GL_FRAGMENT_SHADER);
+    fragmentShader = LoadShader(fragmentSource, defines, GL_FRAGMENT_SHADER);
     
     // Create the final shader program from our vertex and fragment shaders
     programID = glCreateProgram();
@@ -18,25 +47,51 @@ void ShaderProgram::Load(const char *vertexShaderFile, const char *fragmentShade
     GLint linkSuccess;
     glGetProgramiv(programID, GL_LINK_STATUS, &linkSuccess);
     if(linkSuccess == GL_FALSE) {
-	    printf("Error linking shader program!\n");
+	    printf("Error linking shader program %s + %s!\n", Shaders::get_name(vertexSource), Shaders::get_name(fragmentSource));
     }
     
-    modelMatrixUniform = glGetUniformLocation(programID, "modelMatrix");
-    projectionMatrixUniform = glGetUniformLocation(programID, "projectionMatrix");
-    viewMatrixUniform = glGetUniformLocation(programID, "viewMatrix");
-	colorUniform = glGetUniformLocation(programID, "color");
-    lightPositionUniform = glGetUniformLocation(programID, "lightPosition");
+    // Every location is looked up here and nowhere else
+    transformUniforms.model.location = glGetUniformLocation(programID, "modelMatrix");
+    transformUniforms.projection.location = glGetUniformLocation(programID, "projectionMatrix");
+    transformUniforms.view.location = glGetUniformLocation(programID, "viewMatrix");
+	colorUniform.location = glGetUniformLocation(programID, "color");
+    lightUniforms.count.location = glGetUniformLocation(programID, "lightCount");
+    lightUniforms.positions.location = glGetUniformLocation(programID, "lightPositions");
+    lightUniforms.radii.location = glGetUniformLocation(programID, "lightRadii");
+    lightUniforms.intensities.location = glGetUniformLocation(programID, "lightIntensities");
+    lightmapUniforms.sampler.location = glGetUniformLocation(programID, "lightmap");
+    lightmapUniforms.origin.location = glGetUniformLocation(programID, "lightmapOrigin");
+    lightmapUniforms.size.location = glGetUniformLocation(programID, "lightmapSize");
+    paletteUniforms.sampler.location = glGetUniformLocation(programID, "palette");
+    paletteUniforms.paletted.location = glGetUniformLocation(programID, "paletted");
     
     positionAttribute = glGetAttribLocation(programID, "position");
     texCoordAttribute = glGetAttribLocation(programID, "texCoord");
+    tileCellAttribute = glGetAttribLocation(programID, "tileCell");
 	
 	SetColor(1.0f, 1.0f, 1.0f, 1.0f);
     
+    // The diffuse texture stays on unit 0, baked lighting is always read from unit 1, and the palette of
+    // a paletted diffuse texture from unit 2 (see DeviceResources::bind_texture)
+    lightmapUniforms.sampler.Set(1);
+    paletteUniforms.sampler.Set(2);
 }
 
-void ShaderProgram::SetLightPosition(glm::vec3 position) {
+void ShaderProgram::SetLights(int count, const float *positions, const float *radii, const float *intensities) {
     glUseProgram(programID);
-    glUniform2f(lightPositionUniform, position.x, position.y);
+    lightUniforms.count.Set(count);
+    
+    if (count == 0) return;
+    
+    lightUniforms.positions.Set(count, positions);
+    lightUniforms.radii.Set(count, radii);
+    lightUniforms.intensities.Set(count, intensities);
+}
+
+void ShaderProgram::SetLightmap(const glm::vec2 &origin, const glm::vec2 &size) {
+    glUseProgram(programID);
+    lightmapUniforms.origin.Set(origin);
+    lightmapUniforms.size.Set(size);
 }
 
 void ShaderProgram::Cleanup() {
@@ -45,34 +100,17 @@ void ShaderProgram::Cleanup() {
     glDeleteShader(fragmentShader);
 }
 
-GLuint ShaderProgram::LoadShaderFromFile(const std::string &shaderFile, GLenum type) {
-    //Open a file stream with the file name
-    std::ifstream infile(shaderFile);
-    
-    if(infile.fail()) {
-        std::cout << "Error opening shader file:" << shaderFile << std::endl;
-    }
-    
-    //Create a string buffer and stream the file to it
-    std::stringstream buffer;
-    buffer << infile.rdbuf();
-    
-    // Load the shader from the contents of the file
-    return LoadShaderFromString(buffer.str(), type);
-}
-
-GLuint ShaderProgram::LoadShaderFromString(const std::string &shaderContents, GLenum type) {
+GLuint ShaderProgram::LoadShader(ShaderSource source, const std::string &defines, GLenum type) {
     
     
     // Create a shader of specified type
     GLuint shaderID = glCreateShader(type);
     
-    // Get the pointer to the C string from the STL string
-    const char *shaderString = shaderContents.c_str();
-    GLint shaderStringLength = (GLint) shaderContents.size();
+    // The defines go in as a first string, so the embedded text is never copied
+    const char *shaderStrings[] = { defines.c_str(), Shaders::get_text(source) };
     
-    // Set the shader source to the string and compile shader
-    glShaderSource(shaderID, 1, &shaderString, &shaderStringLength);
+    // Set the shader source to the strings and compile shader
+    glShaderSource(shaderID, 2, shaderStrings, NULL);
     glCompileShader(shaderID);
     
     // Check if the shader compiled properly
@@ -83,6 +121,7 @@ GLuint ShaderProgram::LoadShaderFromString(const std::string &shaderContents, GL
     if (compileSuccess == GL_FALSE) {
         GLchar messages[512];
         glGetShaderInfoLog(shaderID, sizeof(messages), 0, &messages[0]);
+        std::cout << "Error compiling " << Shaders::get_name(source) << ":" << std::endl;
         std::cout << messages << std::endl;
     }
     
@@ -92,20 +131,20 @@ GLuint ShaderProgram::LoadShaderFromString(const std::string &shaderContents, GL
 
 void ShaderProgram::SetColor(float r, float g, float b, float a) {
 	glUseProgram(programID);
-	glUniform4f(colorUniform, r, g, b, a);
+	colorUniform.Set(r, g, b, a);
 }
 
 void ShaderProgram::SetViewMatrix(const glm::mat4 &matrix) {
     glUseProgram(programID);
-    glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, &matrix[0][0]);
+    transformUniforms.view.Set(matrix);
 }
 
 void ShaderProgram::SetModelMatrix(const glm::mat4 &matrix) {
     glUseProgram(programID);
-    glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, &matrix[0][0]);
+    transformUniforms.model.Set(matrix);
 }
 
 void ShaderProgram::SetProjectionMatrix(const glm::mat4 &matrix) {
     glUseProgram(programID);
-    glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, &matrix[0][0]);    
+    transformUniforms.projection.Set(matrix);
 }
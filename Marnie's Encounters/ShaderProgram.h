@@ -7,37 +7,97 @@
 #include <SDL_opengl.h>
 #include <string>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include "glm/mat4x4.hpp"
+#include "Shaders.h"
+
+// A uniform's location, looked up once when its program is linked. Uniforms a program doesn't have sit at -1,
+// which GL quietly ignores. Setting one assumes its program is in use.
+struct IntUniform {
+    GLint location = -1;
+    void Set(int value) const { glUniform1i(location, value); }
+};
+
+struct Vec2Uniform {
+    GLint location = -1;
+    void Set(const glm::vec2 &value) const { glUniform2f(location, value.x, value.y); }
+};
+
+struct Vec4Uniform {
+    GLint location = -1;
+    void Set(float r, float g, float b, float a) const { glUniform4f(location, r, g, b, a); }
+};
+
+struct Mat4Uniform {
+    GLint location = -1;
+    void Set(const glm::mat4 &value) const { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+
+struct FloatArrayUniform {
+    GLint location = -1;
+    void Set(int count, const float *values) const { glUniform1fv(location, count, values); }
+};
+
+// Packed x, y pairs
+struct Vec2ArrayUniform {
+    GLint location = -1;
+    void Set(int count, const float *values) const { glUniform2fv(location, count, values); }
+};
+
+struct TransformUniforms {
+    Mat4Uniform model, view, projection;
+};
+
+struct LightUniforms {
+    IntUniform count;
+    Vec2ArrayUniform positions;
+    FloatArrayUniform radii, intensities;
+};
+
+struct LightmapUniforms {
+    IntUniform sampler;
+    Vec2Uniform origin, size;
+};
+
+struct PaletteUniforms {
+    IntUniform sampler;
+    IntUniform paletted;
+};
 
 class ShaderProgram {
-    public:
-	
-		void Load(const char *vertexShaderFile, const char *fragmentShaderFile);
+        ShaderProgram() {}
+
+		void Load(ShaderSource vertexSource, ShaderSource fragmentSource, const std::string &defines);
+        GLuint LoadShader(ShaderSource source, const std::string &defines, GLenum type);
 		void Cleanup();
 
+    public:
+
+        // The program for this pair of shaders, with defines ahead of both. It is compiled and linked the first
+        // time it's asked for, then kept for the life of the process; everyone asking for it shares it, uniforms
+        // and all, so set what you draw with before drawing. GL thread only.
+        static ShaderProgram *Get(ShaderSource vertexSource, ShaderSource fragmentSource, const std::string &defines = "");
+        static void CleanupAll();
+
 		void SetModelMatrix(const glm::mat4 &matrix);
         void SetProjectionMatrix(const glm::mat4 &matrix);
         void SetViewMatrix(const glm::mat4 &matrix);
-        void SetLightPosition(glm::vec3 position);
-	
+        void SetLights(int count, const float *positions, const float *radii, const float *intensities);
+        void SetLightmap(const glm::vec2 &origin, const glm::vec2 &size);
+
 		void SetColor(float r, float g, float b, float a);
-	
-        GLuint LoadShaderFromString(const std::string &shaderContents, GLenum type);
-        GLuint LoadShaderFromFile(const std::string &shaderFile, GLenum type);
-    
+
         GLuint programID;
-    
-        GLuint projectionMatrixUniform;
-        GLuint modelMatrixUniform;
-        GLuint viewMatrixUniform;
-		GLuint colorUniform;
-        GLuint lightPositionUniform;
-	
+
+        TransformUniforms transformUniforms;
+        LightUniforms lightUniforms;
+        LightmapUniforms lightmapUniforms;
+        PaletteUniforms paletteUniforms;
+        Vec4Uniform colorUniform;
+
         GLuint positionAttribute;
         GLuint texCoordAttribute;
-    
+        GLuint tileCellAttribute;
+
         GLuint vertexShader;
         GLuint fragmentShader;
 };
@@ -0,0 +1,53 @@
+#include "Shaders.h"
+
+// Each file in shaders/ is its GLSL wrapped in a raw string literal, so the compiler does the embedding, and
+// editing a shader rebuilds this file like any other header would
+const char VERTEX_TEXT[] =
+#include "shaders/vertex.glsl"
+;
+
+const char FRAGMENT_TEXT[] =
+#include "shaders/fragment.glsl"
+;
+
+const char VERTEX_LIT_TEXT[] =
+#include "shaders/vertex_lit.glsl"
+;
+
+const char FRAGMENT_LIT_TEXT[] =
+#include "shaders/fragment_lit.glsl"
+;
+
+const char VERTEX_TEXTURED_TEXT[] =
+#include "shaders/vertex_textured.glsl"
+;
+
+const char FRAGMENT_TEXTURED_TEXT[] =
+#include "shaders/fragment_textured.glsl"
+;
+
+struct EmbeddedShader
+{
+    const char *name;
+    const char *text;
+};
+
+const EmbeddedShader SHADERS[SHADER_SOURCE_COUNT] =
+{
+    { "shaders/vertex.glsl",            VERTEX_TEXT },
+    { "shaders/fragment.glsl",          FRAGMENT_TEXT },
+    { "shaders/vertex_lit.glsl",        VERTEX_LIT_TEXT },
+    { "shaders/fragment_lit.glsl",      FRAGMENT_LIT_TEXT },
+    { "shaders/vertex_textured.glsl",   VERTEX_TEXTURED_TEXT },
+    { "shaders/fragment_textured.glsl", FRAGMENT_TEXTURED_TEXT }
+};
+
+const char* const Shaders::get_name(ShaderSource source)
+{
+    return SHADERS[source].name;
+}
+
+const char* const Shaders::get_text(ShaderSource source)
+{
+    return SHADERS[source].text;
+}
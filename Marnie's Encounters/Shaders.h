@@ -0,0 +1,20 @@
+#pragma once
+
+// Every GLSL source the game has, compiled into the binary so that building a program never touches the disk
+enum ShaderSource
+{
+    SHADER_VERTEX,
+    SHADER_FRAGMENT,
+    SHADER_VERTEX_LIT,
+    SHADER_FRAGMENT_LIT,
+    SHADER_VERTEX_TEXTURED,
+    SHADER_FRAGMENT_TEXTURED,
+    SHADER_SOURCE_COUNT
+};
+
+class Shaders {
+public:
+    // The file it was embedded from, for error messages
+    static const char* const get_name(ShaderSource source);
+    static const char* const get_text(ShaderSource source);
+};
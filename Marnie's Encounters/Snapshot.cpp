@@ -0,0 +1,139 @@
+#include "Snapshot.h"
+#include "Map.h"
+#include "Utility.h"
+#include "Resources.h"
+
+void RenderSnapshot::clear()
+{
+    scene_id = -1;
+    steps_taken = 0;
+    is_static = false;
+    input_timestamp = 0;
+    map_texture_id = 0;
+    map_regions.clear();
+    view_matrix = glm::mat4(1.0f);
+
+    lights.clear();
+    sprites.clear();
+    texts.clear();
+    batch_count = 0;
+
+    for (int i = 0; i < COUNTER_COUNT; i++) counters[i] = 0;
+}
+
+void RenderSnapshot::add_sprite(GLuint texture_id, glm::mat4 model_matrix, int index, int cols, int rows)
+{
+    SpriteDraw sprite;
+    sprite.texture_id = texture_id;
+    sprite.model_matrix = model_matrix;
+    sprite.index = index;
+    sprite.cols = cols;
+    sprite.rows = rows;
+
+    sprites.push_back(sprite);
+}
+
+void RenderSnapshot::add_text(GLuint font_texture_id, const char *text, float size, float spacing, glm::vec3 position)
+{
+    TextDraw draw;
+    draw.font_texture_id = font_texture_id;
+    draw.text = text;
+    draw.size = size;
+    draw.spacing = spacing;
+    draw.position = position;
+
+    texts.push_back(draw);
+}
+
+BatchDraw &RenderSnapshot::add_batch(GLuint texture_id)
+{
+    // Batches past batch_count are leftovers from earlier frames; reuse their storage
+    if (batch_count == (int) batches.size()) batches.push_back(BatchDraw());
+
+    BatchDraw &batch = batches[batch_count++];
+    batch.texture_id = texture_id;
+    batch.vertices.clear();
+    batch.texture_coordinates.clear();
+
+    return batch;
+}
+
+static void draw_sprite(ShaderProgram *program, Resources *resources, const SpriteDraw &sprite)
+{
+    float vertices[] =
+    {
+        -0.5, -0.5, 0.5, -0.5,  0.5, 0.5,
+        -0.5, -0.5, 0.5,  0.5, -0.5, 0.5
+    };
+
+    float u_coord = 0.0f, v_coord = 0.0f;
+    float width = 1.0f, height = 1.0f;
+
+    if (sprite.index >= 0)
+    {
+        u_coord = (float) (sprite.index % sprite.cols) / (float) sprite.cols;
+        v_coord = (float) (sprite.index / sprite.cols) / (float) sprite.rows;
+        width = 1.0f / (float) sprite.cols;
+        height = 1.0f / (float) sprite.rows;
+    }
+
+    float tex_coords[] =
+    {
+        u_coord, v_coord + height, u_coord + width, v_coord + height, u_coord + width, v_coord,
+        u_coord, v_coord + height, u_coord + width, v_coord, u_coord, v_coord
+    };
+
+    program->SetModelMatrix(sprite.model_matrix);
+
+    resources->bind_texture(program, sprite.texture_id);
+    COUNTER_ADD(COUNTER_TEXTURE_BINDS, 1);
+
+    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
+    glEnableVertexAttribArray(program->positionAttribute);
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
+    glEnableVertexAttribArray(program->texCoordAttribute);
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    COUNTER_ADD(COUNTER_DRAW_CALLS, 1);
+
+    glDisableVertexAttribArray(program->positionAttribute);
+    glDisableVertexAttribArray(program->texCoordAttribute);
+}
+
+static void draw_batch(ShaderProgram *program, Resources *resources, const BatchDraw &batch)
+{
+    if (batch.vertices.empty()) return;
+
+    program->SetModelMatrix(glm::mat4(1.0f));
+
+    resources->bind_texture(program, batch.texture_id);
+    COUNTER_ADD(COUNTER_TEXTURE_BINDS, 1);
+
+    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, batch.vertices.data());
+    glEnableVertexAttribArray(program->positionAttribute);
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, batch.texture_coordinates.data());
+    glEnableVertexAttribArray(program->texCoordAttribute);
+
+    glDrawArrays(GL_TRIANGLES, 0, (int) batch.vertices.size() / 2);
+    COUNTER_ADD(COUNTER_DRAW_CALLS, 1);
+
+    glDisableVertexAttribArray(program->positionAttribute);
+    glDisableVertexAttribArray(program->texCoordAttribute);
+}
+
+void RenderSnapshot::draw(ShaderProgram *program, Lighting *lighting, Resources *resources, TextVertices *text_vertices) const
+{
+    glUseProgram(program->programID);
+
+    // Same order scenes used to draw in: map, sprites, bullets, then text on top
+    if (map_texture_id != 0) Map::render(program, lighting, resources, map_texture_id, map_regions);
+
+    for (size_t i = 0; i < sprites.size(); i++) draw_sprite(program, resources, sprites[i]);
+    for (int i = 0; i < batch_count; i++) draw_batch(program, resources, batches[i]);
+
+    for (size_t i = 0; i < texts.size(); i++)
+    {
+        const TextDraw &text = texts[i];
+        Utility::draw_text(program, resources, text.font_texture_id, text.text, text.size, text.spacing, text.position, text_vertices);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <memory>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "Lighting.h"
+#include "Counters.h"
+#include "Utility.h"
+
+struct MapRegion;
+class Resources;
+
+// One textured quad; index -1 draws the whole texture, anything else one cell of a cols x rows atlas
+struct SpriteDraw
+{
+    GLuint texture_id;
+    glm::mat4 model_matrix;
+    int index;
+    int cols, rows;
+};
+
+struct TextDraw
+{
+    GLuint font_texture_id;
+    const char *text;       // A string literal, so it outlives the snapshot and copying it costs nothing
+    float size, spacing;
+    glm::vec3 position;
+};
+
+// Many quads sharing a texture, already in world space
+struct BatchDraw
+{
+    GLuint texture_id;
+    std::vector<float> vertices;
+    std::vector<float> texture_coordinates;
+};
+
+// Everything needed to draw one frame, copied out of the simulation so the render thread never touches it.
+// Snapshots are reused: clear() keeps every vector's storage, so a warmed-up snapshot never allocates.
+class RenderSnapshot {
+    int batch_count = 0;
+
+public:
+    int scene_id = -1;
+    int steps_taken = 0;
+    bool is_static = false;     // See Scene::is_static
+
+    // SDL timestamp of the oldest input this frame is the first to show, or 0; for latency measurement
+    uint32_t input_timestamp = 0;
+
+    // The regions to draw are held open here, so the simulation can close them, or unload the
+    // whole scene, whenever it likes; 0 means there's no map
+    GLuint map_texture_id = 0;
+    std::vector<std::shared_ptr<const MapRegion>> map_regions;
+
+    glm::mat4 view_matrix = glm::mat4(1.0f);
+    std::vector<Light> lights;
+
+    std::vector<SpriteDraw> sprites;
+    std::vector<BatchDraw> batches;
+    std::vector<TextDraw> texts;
+
+    // The simulation thread's counters for the frame this came from
+    int counters[COUNTER_COUNT];
+
+    void clear();
+
+    void add_sprite(GLuint texture_id, glm::mat4 model_matrix, int index = -1, int cols = 1, int rows = 1);
+    void add_text(GLuint font_texture_id, const char *text, float size, float spacing, glm::vec3 position);
+
+    // An empty batch for this texture, valid until the next call
+    BatchDraw &add_batch(GLuint texture_id);
+
+    int const get_batch_count() const { return batch_count; };
+
+    // Render thread only: the lights must already be culled into lighting
+    void draw(ShaderProgram *program, Lighting *lighting, Resources *resources, TextVertices *text_vertices) const;
+};
@@ -0,0 +1,101 @@
+#include "TextureFormat.h"
+#include <string.h>
+
+// Colours as one word each, so they can be compared and looked up quickly
+static uint32_t texel_colour(const unsigned char *texel)
+{
+    if (texel[3] == 0) return 0;
+    return (uint32_t) texel[0] | (uint32_t) texel[1] << 8 | (uint32_t) texel[2] << 16 | (uint32_t) texel[3] << 24;
+}
+
+// Whether a channel survives being cut to bits and widened again the way GL widens it
+static bool exact_in_bits(unsigned char value, int bits)
+{
+    unsigned char cut = value >> (8 - bits);
+    unsigned char widened = (unsigned char) ((cut << (8 - bits)) | (cut >> (2 * bits - 8)));
+    return widened == value;
+}
+
+// Fills the palette and index texels, or gives up once there are more colours than fit
+static bool build_palette(const unsigned char *rgba, int texel_count, CompactImage *out)
+{
+    // Open addressing over twice the palette, so a lookup rarely probes more than once or twice
+    const int SLOTS = PALETTE_SIZE * 2;
+    uint32_t slot_colours[SLOTS];
+    int slot_indices[SLOTS];
+    for (int i = 0; i < SLOTS; i++) slot_indices[i] = -1;
+
+    out->texels.resize(texel_count);
+    out->palette_count = 0;
+    memset(out->palette, 0, sizeof(out->palette));
+
+    for (int i = 0; i < texel_count; i++)
+    {
+        uint32_t colour = texel_colour(&rgba[i * 4]);
+
+        int slot = (int) ((colour * 2654435761u) >> 23) % SLOTS;
+        while (slot_indices[slot] != -1 && slot_colours[slot] != colour) slot = (slot + 1) % SLOTS;
+
+        if (slot_indices[slot] == -1)
+        {
+            if (out->palette_count == PALETTE_SIZE) return false;
+
+            slot_colours[slot] = colour;
+            slot_indices[slot] = out->palette_count;
+            memcpy(&out->palette[out->palette_count * 4], &colour, 4);
+            out->palette_count++;
+        }
+
+        out->texels[i] = (unsigned char) slot_indices[slot];
+    }
+
+    return true;
+}
+
+void compact_image(const unsigned char *rgba, int width, int height, CompactImage *out)
+{
+    int texel_count = width * height;
+    out->width = width;
+    out->height = height;
+
+    out->format = TEXELS_PALETTED;
+    if (build_palette(rgba, texel_count, out)) return;
+
+    // Too many colours for a palette; maybe every one of them fits in fewer bits
+    bool fits_4444 = true, fits_5551 = true;
+    for (int i = 0; i < texel_count && (fits_4444 || fits_5551); i++)
+    {
+        const unsigned char *texel = &rgba[i * 4];
+        if (texel[3] == 0) continue;
+
+        fits_4444 = fits_4444 && exact_in_bits(texel[0], 4) && exact_in_bits(texel[1], 4) && exact_in_bits(texel[2], 4) && exact_in_bits(texel[3], 4);
+        fits_5551 = fits_5551 && exact_in_bits(texel[0], 5) && exact_in_bits(texel[1], 5) && exact_in_bits(texel[2], 5) && texel[3] == 255;
+    }
+
+    if (fits_4444 || fits_5551)
+    {
+        out->format = fits_4444 ? TEXELS_RGBA4444 : TEXELS_RGB5A1;
+        out->texels.resize(texel_count * 2);
+        uint16_t *packed = (uint16_t*) out->texels.data();
+
+        for (int i = 0; i < texel_count; i++)
+        {
+            const unsigned char *texel = &rgba[i * 4];
+
+            if (texel[3] == 0) packed[i] = 0;
+            else if (fits_4444) packed[i] = (uint16_t) ((texel[0] >> 4) << 12 | (texel[1] >> 4) << 8 | (texel[2] >> 4) << 4 | texel[3] >> 4);
+            else packed[i] = (uint16_t) ((texel[0] >> 3) << 11 | (texel[1] >> 3) << 6 | (texel[2] >> 3) << 1 | 1);
+        }
+        return;
+    }
+
+    out->format = TEXELS_RGBA8;
+    out->texels.assign(rgba, rgba + texel_count * 4);
+}
+
+int64_t const compact_image_bytes(const CompactImage &image)
+{
+    int64_t bytes = (int64_t) image.texels.size();
+    if (image.format == TEXELS_PALETTED) bytes += PALETTE_SIZE * 4;
+    return bytes;
+}
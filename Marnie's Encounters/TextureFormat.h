@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Entries in a palette texture, which is PALETTE_SIZE x 1 RGBA
+#define PALETTE_SIZE 256
+
+// How an image's texels are stored on the GPU, smallest first
+enum TexelFormat
+{
+    TEXELS_PALETTED,    // One byte, an index into a palette texture; see DeviceResources::bind_texture
+    TEXELS_RGBA4444,    // Two bytes, packed GL_UNSIGNED_SHORT_4_4_4_4
+    TEXELS_RGB5A1,      // Two bytes, packed GL_UNSIGNED_SHORT_5_5_5_1
+    TEXELS_RGBA8        // Four bytes, as decoded
+};
+
+struct CompactImage
+{
+    TexelFormat format;
+    int width, height;
+    std::vector<unsigned char> texels;
+    unsigned char palette[PALETTE_SIZE * 4];    // TEXELS_PALETTED only; unused entries are zero
+    int palette_count;
+};
+
+// Picks the smallest format that draws exactly like the RGBA8 image it is given. Pixel art rarely has many
+// colours, so it usually ends up paletted. Invisible texels count as transparent black whatever their colour,
+// since nothing ever shows it.
+void compact_image(const unsigned char *rgba, int width, int height, CompactImage *out);
+
+// What an image in that format takes up on the GPU, palette included
+int64_t const compact_image_bytes(const CompactImage &image);
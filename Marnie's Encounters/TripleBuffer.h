@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+
+// One writer and one reader handing whole values over without locks or waiting.
+// The writer fills its back buffer and swaps it into the middle; the reader swaps the middle
+// out whenever something new is there. Neither side ever holds the buffer the other is using,
+// and a reader that falls behind simply skips to the newest value.
+template <typename T>
+class TripleBuffer {
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;     // Set on the middle index when it holds something the reader hasn't seen
+
+    T buffers[3];
+
+    int back = 0;                   // Writer's
+    std::atomic<int> middle;
+    int front = 2;                  // Reader's
+
+public:
+    TripleBuffer() : middle(1) {};
+
+    // Writer side
+    T &write_buffer() { return buffers[back]; };
+    void publish() { back = middle.exchange(back | FRESH) & INDEX_MASK; };
+
+    // Reader side: true when read_buffer() now holds something newer than last time
+    bool acquire()
+    {
+        if ((middle.load() & FRESH) == 0) return false;
+
+        front = middle.exchange(front) & INDEX_MASK;
+        return true;
+    };
+    const T &read_buffer() const { return buffers[front]; };
+};
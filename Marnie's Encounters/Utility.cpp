@@ -1,46 +1,21 @@
 #define LOG(argument) std::cout << argument << '\n'
+#define STBI_NO_FAILURE_STRINGS  // the failure string is one unguarded global, and textures decode on several threads
 #define STB_IMAGE_IMPLEMENTATION
-#define NUMBER_OF_TEXTURES 1 // to be generated, that is
-#define LEVEL_OF_DETAIL 0    // base image level; Level n is the nth mipmap reduction image
-#define TEXTURE_BORDER 0     // this value MUST be zero
 #define FONTBANK_SIZE 16
 
 #include "Utility.h"
+#include "Counters.h"
+#include "Resources.h"
 #include <SDL_image.h>
 #include "stb_image.h"
+#include <string.h>
 
-GLuint Utility::load_texture(const char* filepath) {
-    // STEP 1: Loading the image file
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
-    
-    if (image == NULL)
-    {
-        LOG("Unable to load image. Make sure the path is correct.");
-        assert(false);
-    }
-    
-    // STEP 2: Generating and binding a texture ID to our image
-    GLuint texture_id;
-    glGenTextures(NUMBER_OF_TEXTURES, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    
-    // STEP 3: Setting our texture filter modes
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    
-    // STEP 4: Setting our texture wrapping modes
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // the last argument can change depending on what you are looking for
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    
-    // STEP 5: Releasing our file from memory and returning our texture id
-    stbi_image_free(image);
-    
-    return texture_id;
+void Utility::draw_text(ShaderProgram *program, Resources *resources, GLuint font_texture_id, const char *text, float screen_size, float spacing, glm::vec3 position, TextVertices *buffers)
+{
+    draw_text(program, resources, font_texture_id, text, (int) strlen(text), screen_size, spacing, position, buffers);
 }
 
-void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position)
+void Utility::draw_text(ShaderProgram *program, Resources *resources, GLuint font_texture_id, const char *text, int length, float screen_size, float spacing, glm::vec3 position, TextVertices *buffers)
 {
     // Scale the size of the fontbank in the UV-plane
     // We will use this for spacing and positioning
@@ -49,11 +24,14 @@ void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::str
 
     // Instead of having a single pair of arrays, we'll have a series of pairs—one for each character
     // Don't forget to include <vector>!
-    std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    // The caller's pair, reused call after call without allocating once it has grown to the longest text
+    std::vector<float> &vertices = buffers->vertices;
+    std::vector<float> &texture_coordinates = buffers->texture_coordinates;
+    vertices.clear();
+    texture_coordinates.clear();
 
     // For every character...
-    for (int i = 0; i < text.size(); i++) {
+    for (int i = 0; i < length; i++) {
         // 1. Get their index in the spritesheet, as well as their offset (i.e. their position
         //    relative to the whole sentence)
         int spritesheet_index = (int) text[i];  // ascii value of character
@@ -95,14 +73,16 @@ void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::str
     glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texture_coordinates.data());
     glEnableVertexAttribArray(program->texCoordAttribute);
     
-    glBindTexture(GL_TEXTURE_2D, font_texture_id);
-    glDrawArrays(GL_TRIANGLES, 0, (int) (text.size() * 6));
+    resources->bind_texture(program, font_texture_id);
+    glDrawArrays(GL_TRIANGLES, 0, length * 6);
+    COUNTER_ADD(COUNTER_TEXTURE_BINDS, 1);
+    COUNTER_ADD(COUNTER_DRAW_CALLS, 1);
     
     glDisableVertexAttribArray(program->positionAttribute);
     glDisableVertexAttribArray(program->texCoordAttribute);
 }
 
 
-float Utility::random(float a, float b) {
-    return ((b - a) * ((float)rand() / RAND_MAX)) + a;
+float Utility::random(Rng &rng, float a, float b) {
+    return rng.range(a, b);
 }
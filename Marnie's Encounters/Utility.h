@@ -12,10 +12,29 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "Random.h"
+
+class Resources;
+
+// Characters TextVertices has room for from the start; the HUD's lines are the longest text drawn
+#define TEXT_RESERVED_LENGTH 64
+
+// Vertex storage for draw_text, kept by whoever draws text so that drawing reuses it rather than allocating
+struct TextVertices
+{
+    std::vector<float> vertices;
+    std::vector<float> texture_coordinates;
+
+    TextVertices()
+    {
+        vertices.reserve(TEXT_RESERVED_LENGTH * 12);
+        texture_coordinates.reserve(TEXT_RESERVED_LENGTH * 12);
+    }
+};
 
 class Utility {
 public:
-    static GLuint load_texture(const char* filepath);
-    static void draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position);
-    static float random(float a, float b);
+    static void draw_text(ShaderProgram *program, Resources *resources, GLuint font_texture_id, const char *text, int length, float screen_size, float spacing, glm::vec3 position, TextVertices *buffers);
+    static void draw_text(ShaderProgram *program, Resources *resources, GLuint font_texture_id, const char *text, float screen_size, float spacing, glm::vec3 position, TextVertices *buffers);
+    static float random(Rng &rng, float a, float b);
 };
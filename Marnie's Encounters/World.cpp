@@ -1,58 +1,52 @@
 #include "World.h"
 #include "Utility.h"
+#include "Counters.h"
 
-#define LEVEL_WIDTH 30
-#define LEVEL_HEIGHT 8
 #define LOG(argument) std::cout << argument << '\n'
 
 const int FONTBANK_SIZE = 16;
 
-unsigned int WORLD_DATA[] =
+// Every texture the scene draws with, asked for together so they decode in parallel
+const char* const WORLD_TEXTURES[] =
 {
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2
+    "assets/tileset.png",
+    "assets/font1.png",
+    "assets/marnie_0.png",
+    "assets/trainer3.png",
+    "assets/trainer3_flip.png",
+    "assets/trainer1.png",
+    "assets/trainer2.png"
 };
-
-World::~World()
-{
-    delete [] this->state.enemies;
-    delete    this->state.player;
-    delete    this->state.map;
-    Mix_FreeChunk(this->state.jump_sfx);
-    Mix_FreeMusic(this->state.bgm);
-}
+const int WORLD_TEXTURE_COUNT = sizeof(WORLD_TEXTURES) / sizeof(WORLD_TEXTURES[0]);
 
 void World::initialise()
 {
     state.next_scene_id = -1;
+    state.resources->preload_textures(WORLD_TEXTURES, WORLD_TEXTURE_COUNT);
     
-    GLuint map_texture_id = Utility::load_texture("assets/tileset.png");
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, WORLD_DATA, map_texture_id, 1.0f, 4, 1);
+    GLuint map_texture_id = state.resources->texture("assets/tileset.png");
+    font_texture_id = state.resources->texture("assets/font1.png");
+    // Streamed: the regions around the player are opened, lit by their torches and populated as they come near
+    this->state.map = arena.create<Map>(new Level("levels/world.lvl"), map_texture_id, state.resources);
     
     // Code from main.cpp's initialise()
     /**
      George's Stuff
      */
     // Existing
-    state.player = new Entity();
+    state.player = arena.create<Entity>();
     state.player->set_entity_type(PLAYER);
-    state.player->set_position(glm::vec3(3.0f, 1.0f, 0.0f));
+    state.player->set_position(player_spawn());
     state.player->set_movement(glm::vec3(0.0f));
     state.player->speed = 2.5f;
     state.player->set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/marnie_0.png");
+    state.player->texture_id = state.resources->texture("assets/marnie_0.png");
     
     // Walking
-    state.player->walking[state.player->LEFT]  = new int[4] { 1, 5, 9,  13 };
-    state.player->walking[state.player->RIGHT] = new int[4] { 3, 7, 11, 15 };
-    state.player->walking[state.player->UP]    = new int[4] { 2, 6, 10, 14 };
-    state.player->walking[state.player->DOWN]  = new int[4] { 0, 4, 8,  12 };
+    state.player->walking[state.player->LEFT]  = arena.copy_array({ 1, 5, 9,  13 });
+    state.player->walking[state.player->RIGHT] = arena.copy_array({ 3, 7, 11, 15 });
+    state.player->walking[state.player->UP]    = arena.copy_array({ 2, 6, 10, 14 });
+    state.player->walking[state.player->DOWN]  = arena.copy_array({ 0, 4, 8,  12 });
 
     state.player->animation_indices = state.player->walking[state.player->RIGHT];  // start George looking left
     state.player->animation_frames = 4;
@@ -68,90 +62,148 @@ void World::initialise()
     
     /**
      Enemies' stuff */
-    GLuint enemy1_texture_id = Utility::load_texture("assets/trainer3.png");
-    GLuint enemy1_texture_id2 = Utility::load_texture("assets/trainer3_flip.png");
-    GLuint enemy2_texture_id = Utility::load_texture("assets/trainer1.png");
-    GLuint enemy3_texture_id = Utility::load_texture("assets/trainer2.png");
+    GLuint enemy1_texture_id = state.resources->texture("assets/trainer3.png");
+    GLuint enemy1_texture_id2 = state.resources->texture("assets/trainer3_flip.png");
+    GLuint enemy2_texture_id = state.resources->texture("assets/trainer1.png");
+    GLuint enemy3_texture_id = state.resources->texture("assets/trainer2.png");
     
-    state.enemies = new Entity[this->ENEMY_COUNT];
-    state.enemies[0].set_entity_type(ENEMY);
-    state.enemies[0].set_ai_type(STANDER);
-    state.enemies[0].set_ai_state(IDLE);
-    state.enemies[0].texture_id = enemy2_texture_id;
-    state.enemies[0].set_position(glm::vec3(8.0f, 5.0f, 0.0f));
-    state.enemies[0].set_movement(glm::vec3(0.0f));
-    state.enemies[0].speed = 1.0f;
-    state.enemies[0].set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
-    state.enemies[0].set_height(0.8f);
-    state.enemies[0].set_width(0.8f);
-
-    state.enemies[1].set_entity_type(ENEMY);
-    state.enemies[1].set_ai_type(STANDER);
-    state.enemies[1].set_ai_state(IDLE);
-    state.enemies[1].texture_id = enemy3_texture_id;
-    state.enemies[1].set_position(glm::vec3(16.0f, 5.0f, 0.0f));
-    state.enemies[1].set_movement(glm::vec3(0.0f));
-    state.enemies[1].speed = 1.0f;
-    state.enemies[1].set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
-    state.enemies[1].set_height(0.8f);
-    state.enemies[1].set_width(0.8f);
-
-    state.enemies[2].set_entity_type(ENEMY);
-    state.enemies[2].set_ai_type(STANDER);
-    state.enemies[2].set_ai_state(IDLE);
-    state.enemies[2].texture_id = enemy1_texture_id;
-    state.enemies[2].backup1 = enemy1_texture_id2;
-    state.enemies[2].backup2 = enemy1_texture_id;
-    state.enemies[2].set_position(glm::vec3(24.0f, 10.0f, 0.0f));
-    state.enemies[2].set_movement(glm::vec3(0.0f));
-    state.enemies[2].speed = 1.0f;
-    state.enemies[2].set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
-    state.enemies[2].set_height(1.0f);
-    state.enemies[2].set_width(1.0f);
+    // The variant of an enemy spawn says which trainer
+    trainer_texture_ids[0] = enemy2_texture_id;
+    trainer_texture_ids[1] = enemy3_texture_id;
+    trainer_texture_ids[2] = enemy1_texture_id;
+    trainer_turned_texture_id = enemy1_texture_id2;
+    
+    // Every slot starts free; regions fill them as they become active
+    state.enemies = arena.create_array<Entity>(WORLD_ENEMY_SLOTS);
+    for (int i = 0; i < WORLD_ENEMY_SLOTS; i++) {
+        state.enemies[i].is_active = false;
+        enemy_regions[i] = -1;
+    }
+    this->ENEMY_COUNT = 0;
+    
+    populated_regions.assign(this->state.map->get_region_count(), false);
+    this->state.map->stream(state.player->get_position(), this->state.lighting);
+    populate_regions();
     
     /**
      BGM and SFX
      */
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
     
-    state.bgm = Mix_LoadMUS("assets/marnie.mp3");
-    Mix_PlayMusic(state.bgm, -1);
-    Mix_VolumeMusic(50.0f);
+    state.bgm = state.resources->music("assets/marnie.mp3");
+    state.resources->play_music(state.bgm);
+    state.resources->set_music_volume(50);
+    
+    state.jump_sfx = state.resources->sound("assets/bounce.wav");
+    state.win_sfx = state.resources->sound("assets/win.wav");
+    state.lose_sfx = state.resources->sound("assets/lose.wav");
+}
+
+void World::populate_regions()
+{
+    for (int i = 0; i < this->state.map->get_region_count(); i++) {
+        bool active = this->state.map->is_region_active(i);
+        if (active == populated_regions[i]) continue;
+        
+        if (active) spawn_enemies(i);
+        else despawn_enemies(i);
+        populated_regions[i] = active;
+    }
+}
+
+void World::spawn_enemies(int region)
+{
+    const Level *level = this->state.map->get_region_level(region);
     
-    state.jump_sfx = Mix_LoadWAV("assets/bounce.wav");
-    state.win_sfx = Mix_LoadWAV("assets/win.wav");
-    state.lose_sfx = Mix_LoadWAV("assets/lose.wav");
+    for (int i = 0; i < level->get_spawn_count(); i++) {
+        const LevelSpawn &spawn = level->get_spawn(i);
+        if (spawn.type != SPAWN_ENEMY) continue;
+        
+        int enemy = 0;
+        while (enemy < WORLD_ENEMY_SLOTS && enemy_regions[enemy] != -1) enemy++;
+        
+        if (enemy == WORLD_ENEMY_SLOTS) {
+            LOG("Region " << region << " has more enemies than the " << WORLD_ENEMY_SLOTS << " slots left room for");
+            return;
+        }
+        
+        // Slots are reused, so each enemy starts from a freshly made Entity
+        state.enemies[enemy] = Entity();
+        enemy_regions[enemy] = region;
+        if (enemy + 1 > this->ENEMY_COUNT) this->ENEMY_COUNT = enemy + 1;
+        
+        int variant = spawn.variant < TRAINER_VARIANT_COUNT ? spawn.variant : 0;
+        
+        state.enemies[enemy].set_entity_type(ENEMY);
+        state.enemies[enemy].set_ai_type(STANDER);
+        state.enemies[enemy].set_ai_state(IDLE);
+        state.enemies[enemy].texture_id = trainer_texture_ids[variant];
+        state.enemies[enemy].set_position(glm::vec3(spawn.x, spawn.y, 0.0f));
+        state.enemies[enemy].set_movement(glm::vec3(0.0f));
+        state.enemies[enemy].speed = 1.0f;
+        state.enemies[enemy].set_acceleration(glm::vec3(0.0f, -9.81f, 0.0f));
+        state.enemies[enemy].set_width(spawn.values[0]);
+        state.enemies[enemy].set_height(spawn.values[1]);
+        
+        // This one turns to face the player
+        if (variant == 2) {
+            state.enemies[enemy].backup1 = trainer_turned_texture_id;
+            state.enemies[enemy].backup2 = trainer_texture_ids[2];
+        }
+    }
+}
+
+void World::despawn_enemies(int region)
+{
+    // Whatever happened to them is forgotten; they'll be back as they started if the region comes back
+    for (int i = 0; i < this->ENEMY_COUNT; i++) {
+        if (enemy_regions[i] != region) continue;
+        
+        state.enemies[i].is_active = false;
+        enemy_regions[i] = -1;
+    }
+    
+    while (this->ENEMY_COUNT > 0 && enemy_regions[this->ENEMY_COUNT - 1] == -1) this->ENEMY_COUNT--;
 }
 
 void World::update(float delta_time)
 {
+    PROFILE_ZONE("World::update");
+    
+    // Decided by where the player is, so a replay streams and spawns on the same steps
+    this->state.map->stream(state.player->get_position(), this->state.lighting);
+    populate_regions();
+    
+    COUNTER_SET(COUNTER_ENTITIES, 1 + ENEMY_COUNT);
+
     this->state.player->update(delta_time, state.player, state.enemies, this->ENEMY_COUNT, this->state.map);
 
     for (int i = 0; i < ENEMY_COUNT; i++) {
         state.enemies[i].update(delta_time, state.player, state.enemies, this->ENEMY_COUNT, this->state.map);
     }
-}
-
-void World::render(ShaderProgram *program) {
-    this->state.map->render(program);
-    this->state.player->render(program);
 
-    if (this->state.player->get_position().y < -10.0f) {
-        Utility::draw_text(program, Utility::load_texture("assets/font1.png"), "You've won!", 0.5f, 0.001f, glm::vec3(3.0f, -3.0f, 0.0f));
-
-        if (!played) {
-            played = true;
-            Mix_PlayChannel(-1, state.win_sfx, 0);
-            Mix_HaltMusic();
-            state.player->set_position(glm::vec3(3.0f, 1.0f, 0.0f));
-        }
+    // Game rules live here rather than in render(), so runs nobody draws play out the same
+    if (this->state.player->get_position().y < -10.0f && !played) {
+        played = true;
+        state.resources->play_sound(state.win_sfx);
+        state.resources->halt_music();
+        state.player->set_position(player_spawn());
     }
 
     if (!state.player->is_active) {
         this->state.next_scene_id = 2;
     }
+}
+
+void World::snapshot(RenderSnapshot *snapshot) {
+    this->state.map->snapshot(snapshot);
+    this->state.player->snapshot(snapshot);
+
+    // Only below the map, as it always has been; winning itself puts the player back at the spawn
+    if (this->state.player->get_position().y < -10.0f) {
+        snapshot->add_text(font_texture_id, "You've won!", 0.5f, 0.001f, glm::vec3(3.0f, -3.0f, 0.0f));
+    }
 
     for (int i = 0; i < ENEMY_COUNT; i++) {
-        state.enemies[i].render(program);
+        state.enemies[i].snapshot(snapshot);
     }
 }
@@ -1,14 +1,32 @@
 #include "Scene.h"
 
+// Enemy spawn variants: trainer1, trainer2 and trainer3
+const int TRAINER_VARIANT_COUNT = 3;
+
+// Enemies come and go with the regions of the streamed world, in a pool that never grows
+const int WORLD_ENEMY_SLOTS = 32;
+
 class World : public Scene {
+    // Which region each enemy slot was spawned for, -1 when free; and whether each region's enemies are out
+    int enemy_regions[WORLD_ENEMY_SLOTS];
+    std::vector<bool> populated_regions;
+    
+    GLuint trainer_texture_ids[TRAINER_VARIANT_COUNT];
+    GLuint trainer_turned_texture_id = 0;
+    
+    void populate_regions();
+    void spawn_enemies(int region);
+    void despawn_enemies(int region);
+    
 public:
-    int ENEMY_COUNT = 3;
+    int ENEMY_COUNT = 0;    // Slots in use, up to the last taken; free ones in between are inactive
 
     bool played = false;
-    
-    ~World();
+    GLuint font_texture_id = 0;
     
     void initialise() override;
     void update(float delta_time) override;
-    void render(ShaderProgram *program) override;
+    void snapshot(RenderSnapshot *snapshot) override;
+    
+    int arena_entity_count() const override { return state.player != nullptr ? 1 + WORLD_ENEMY_SLOTS : 0; }
 };
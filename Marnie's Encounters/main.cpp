@@ -1,9 +1,7 @@
 #define GL_SILENCE_DEPRECATION
 #define GL_GLEXT_PROTOTYPES 1
-#define FIXED_TIMESTEP 0.0166666f
 #define LEVEL1_WIDTH 14
 #define LEVEL1_HEIGHT 8
-#define LEVEL1_LEFT_EDGE 5.0f
 #define LOG(argument) std::cout << argument << '\n'
 
 #ifdef _WINDOWS
@@ -19,16 +17,30 @@
 #include "cmath"
 #include <ctime>
 #include <vector>
+#include <string.h>
+#include <stdlib.h>
+#include <thread>
+#include <atomic>
 #include "Entity.h"
 #include "Map.h"
 #include "Utility.h"
 #include "Scene.h"
 #include "Effects.h"
-
-#include "World.h"
-#include "EncounterA.h"
-#include "EncounterB.h"
-#include "Menu.h"
+#include "Lighting.h"
+#include "Profiler.h"
+#include "Counters.h"
+#include "Allocations.h"
+#include "Hud.h"
+#include "Input.h"
+#include "Random.h"
+#include "Resources.h"
+#include "Game.h"
+#include "Jobs.h"
+#include "Snapshot.h"
+#include "TripleBuffer.h"
+#include "Pacer.h"
+#include "Latency.h"
+#include "Level.h"
 
 /**
  CONSTANTS
@@ -46,43 +58,129 @@ const int VIEWPORT_X = 0,
           VIEWPORT_WIDTH  = WINDOW_WIDTH,
           VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 
-const char V_SHADER_PATH[] = "shaders/vertex_lit.glsl",
-           F_SHADER_PATH[] = "shaders/fragment_lit.glsl";
-
 const float MILLISECONDS_IN_SECOND = 1000.0;
 
+const char PROFILE_PATH[] = "trace.json";
+
+// Frame rate to hold when vsync isn't available, or when nothing needs drawing
+const float RENDER_INTERVAL = 1.0f / 60.0f;
+
+// How often shutdown checks whether the simulation has stopped
+const Uint32 SHUTDOWN_POLL_MS = 1;
+
 /**
  VARIABLES
  */
-Scene *current_scene;
-World *world;
-EncounterA *encounterA;
-EncounterB *encounterB;
-Menu* menu;
+// The game being played and shown; headless runs make their own and never touch these
+Game *game;
+DeviceResources *resources;
 
-Effects *effects;
+// Shared by everything that runs in parallel, headless copies included
+JobSystem *jobs;
 
-Scene *levels[4];
+Effects *effects;
+Hud *hud;
 
 SDL_Window* display_window;
-bool game_is_running = true;
+std::atomic<bool> game_is_running(true);
 
-ShaderProgram program;
-glm::mat4 view_matrix, projection_matrix;
+// The simulation runs on its own thread and hands finished frames to the render loop through here.
+// Neither side waits for the other: rendering redraws the newest snapshot, stepping never stalls on a swap.
+std::thread simulation;
+std::atomic<bool> simulation_finished(false);
+
+// Set by F3; the simulation prints the memory report, since the scenes are its to read
+std::atomic<bool> memory_report_requested(false);
+TripleBuffer<RenderSnapshot> *snapshots;
 
-float previous_ticks = 0.0f;
-float accumulator = 0.0f;
+// The render thread's copy of the lights; the game's own Lighting belongs to the simulation
+Lighting *render_lighting;
 
-bool is_colliding_bottom = false;
+// With vsync the swap itself holds the frame rate; otherwise render_pacer does
+bool vsync = false;
+FramePacer render_pacer;
 
-void switch_to_scene(Scene *scene) {
-    current_scene = scene;
-    current_scene->initialise(); // DON'T FORGET THIS STEP!
+// Render on demand: a static scene is drawn once and then left alone until something asks for a redraw
+int shown_static_scene_id = -1;
+
+// A new scene's first frames upload its textures and size the draw lists, so they're let off the allocation budget
+int rendered_scene_id = -1;
+bool redraw_requested = true;
+
+// Key event to swap, for every frame that was the first to show an input; the HUD shows it
+LatencyHistogram input_latency;
+
+// The oldest input stepped on that no swapped frame has shown yet, or 0. The simulation merges into it and
+// stamps every snapshot with it until the render thread, having swapped one of those, clears it. So a snapshot
+// superseded before it was drawn hands its input on to the next one instead of dropping the sample.
+std::atomic<uint32_t> unreported_input_timestamp(0);
+
+// Set from the command line: --record <file>, --replay <file>, --seed <n>, --headless, --copies <n>, --workers <n>,
+// --build-level <source> <output>
+const char *record_path = nullptr;
+const char *replay_path = nullptr;
+bool headless = false;
+int headless_copies = 1;
+int worker_count = -1;
+uint64_t seed = 0;
+
+// Compile a text level to its binary form and exit, without starting the game
+const char *level_source_path = nullptr;
+const char *level_output_path = nullptr;
+
+// Fixed steps only ever see input through input_stream; live_input is what the keyboard says
+LiveInput live_input;
+InputStream *input_stream = &live_input;
+
+ShaderProgram *program;
+TextVertices text_vertices;     // Reused by every snapshot's text, render thread only
+glm::mat4 view_matrix, projection_matrix;
+
+Uint64 previous_frame_counter = 0;
+
+void parse_arguments(int argc, char* argv[])
+{
+    seed = (uint64_t) time(NULL);
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)                 headless = true;
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) record_path = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replay_path = argv[++i];
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)   seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--copies") == 0 && i + 1 < argc) headless_copies = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) worker_count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--build-level") == 0 && i + 2 < argc) {
+            level_source_path = argv[++i];
+            level_output_path = argv[++i];
+        }
+    }
+    
+    if (replay_path != nullptr) {
+        InputReplay *replay = new InputReplay(replay_path);
+        if (replay->is_valid()) {
+            // A replay only reproduces the run if the randomness starts where the recording's did
+            seed = replay->get_seed();
+            input_stream = replay;
+        } else {
+            delete replay;
+        }
+    } else if (record_path != nullptr) {
+        input_stream = new InputRecorder(&live_input, record_path, seed);
+    }
+    
+    // Without a replay to drive it, a headless run would never end
+    if (input_stream == &live_input) headless = false;
+    if (headless_copies < 1) headless_copies = 1;
+    
+    jobs = new JobSystem(worker_count);
 }
 
 void initialise()
 {
+    PROFILE_THREAD("main");
+    
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+    
     display_window = SDL_CreateWindow("Marnie's Adventure - Preston Tang - 8/13/2022",
                                       SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                                       WINDOW_WIDTH, WINDOW_HEIGHT,
@@ -90,6 +188,7 @@ void initialise()
     
     SDL_GLContext context = SDL_GL_CreateContext(display_window);
     SDL_GL_MakeCurrent(display_window, context);
+    vsync = SDL_GL_SetSwapInterval(1) == 0;
     
 #ifdef _WINDOWS
     glewInit();
@@ -97,15 +196,16 @@ void initialise()
     
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
     
-    program.Load(V_SHADER_PATH, F_SHADER_PATH);
+    // The lit shader's light arrays are sized by the same MAX_LIGHTS the CPU culls to
+    program = ShaderProgram::Get(SHADER_VERTEX_LIT, SHADER_FRAGMENT_LIT, "#define MAX_LIGHTS " + std::to_string(MAX_LIGHTS) + "\n");
     
     view_matrix = glm::mat4(1.0f);
     projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
     
-    program.SetProjectionMatrix(projection_matrix);
-    program.SetViewMatrix(view_matrix);
+    program->SetProjectionMatrix(projection_matrix);
+    program->SetViewMatrix(view_matrix);
     
-    glUseProgram(program.programID);
+    glUseProgram(program->programID);
     
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
     
@@ -113,31 +213,59 @@ void initialise()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    world = new World();
-    encounterA = new EncounterA();
-    encounterB = new EncounterB();
-    menu = new Menu();
-    
-    levels[0] = menu;
-    levels[1] = world;
-    levels[2] = encounterA;
-    levels[3] = encounterB;
-
-    switch_to_scene(levels[0]);
-    menu->state.player->lives = 1;
+    resources = new DeviceResources(jobs);
+    game = new Game(resources, jobs, seed);
     
-    effects = new Effects(projection_matrix, view_matrix);
+    // Only effects ever draw from this stream, so it's safe to use from here while the game steps elsewhere
+    effects = new Effects(projection_matrix, view_matrix, &game->get_random().stream(RNG_EFFECTS));
     effects->start(FADEIN, 3.0f);
+    
+    hud = new Hud(projection_matrix, resources);
+    hud->show_latency(&input_latency);
+    
+    render_lighting = new Lighting();
+    
+    // Something to draw before the simulation publishes its first frame
+    snapshots = new TripleBuffer<RenderSnapshot>();
+    game->snapshot(&snapshots->write_buffer());
+    snapshots->publish();
+}
+
+// Which game button a key is, or 0 for keys the game doesn't use
+uint8_t const button_for_key(SDL_Scancode scancode)
+{
+    switch (scancode) {
+        case SDL_SCANCODE_A:      return INPUT_LEFT;
+        case SDL_SCANCODE_D:      return INPUT_RIGHT;
+        case SDL_SCANCODE_W:      return INPUT_UP;
+        case SDL_SCANCODE_S:      return INPUT_DOWN;
+        case SDL_SCANCODE_SPACE:  return INPUT_JUMP;
+        case SDL_SCANCODE_RETURN: return INPUT_START;
+        default:                  return 0;
+    }
 }
 
 void process_input()
 {
-    // VERY IMPORTANT: If nothing is pressed, we don't want to go anywhere
-    current_scene->state.player->set_movement(glm::vec3(0.0f));
+    PROFILE_ZONE("process_input");
     
     SDL_Event event;
     while (SDL_PollEvent(&event))
     {
+        // Game buttons go to the steps with the time they happened; only presses repeat
+        if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+            uint8_t button = button_for_key(event.key.keysym.scancode);
+            bool down = event.type == SDL_KEYDOWN;
+            
+            if (button != 0 && !(down && event.key.repeat && (button & INPUT_PRESS_ONLY) == 0)) {
+                InputEvent input_event;
+                input_event.timestamp = event.key.timestamp;
+                input_event.button = (InputButton) button;
+                input_event.down = down;
+                live_input.push(input_event);
+            }
+        }
+        
         switch (event.type) {
             // End game
             case SDL_QUIT:
@@ -145,6 +273,11 @@ void process_input()
                 game_is_running = false;
                 break;
                 
+            case SDL_WINDOWEVENT:
+                // Exposed, resized, restored... whatever it was, what's on screen may be gone
+                redraw_requested = true;
+                break;
+                
             case SDL_KEYDOWN:
                 switch (event.key.keysym.sym) {
                     case SDLK_q:
@@ -152,18 +285,19 @@ void process_input()
                         game_is_running = false;
                         break;
                         
-                    case SDLK_SPACE:
-                        // Jump
-                        if (current_scene->state.player->collided_bottom) {
-                            Mix_PlayChannel(-1, current_scene->state.jump_sfx, 0);
-                            current_scene->state.player->is_jumping = true;
-                        }
+                    case SDLK_F1:
+                        hud->toggle();
+                        redraw_requested = true;
+                        break;
+                        
+                    case SDLK_F2:
+                        // Dump the last few seconds of zones for chrome://tracing
+                        Profiler::dump(PROFILE_PATH);
+                        break;
+                        
+                    case SDLK_F3:
+                        memory_report_requested = true;
                         break;
-
-                    case SDLK_RETURN:
-                        if (current_scene == menu) {
-                            current_scene->state.next_scene_id = 1;
-                        }
                         
                     default:
                         break;
@@ -173,132 +307,250 @@ void process_input()
                 break;
         }
     }
-    
-    const Uint8 *key_state = SDL_GetKeyboardState(NULL);
-
-    // Supports WASD and Arrow Keys
-    if (key_state[SDL_SCANCODE_A])
-    {
-        current_scene->state.player->movement.x = -1.0f;
-        current_scene->state.player->animation_indices = current_scene->state.player->walking[current_scene->state.player->LEFT];
-    }
-    else if (key_state[SDL_SCANCODE_D])
-    {
-        current_scene->state.player->movement.x = 1.0f;
-        current_scene->state.player->animation_indices = current_scene->state.player->walking[current_scene->state.player->RIGHT];
-    }
-    else if (key_state[SDL_SCANCODE_W] && current_scene != world)
-    {
-        current_scene->state.player->movement.y = 1.0f;
-        current_scene->state.player->animation_indices = current_scene->state.player->walking[current_scene->state.player->UP];
-    }
-    else if (key_state[SDL_SCANCODE_S] && current_scene != world)
-    {
-        current_scene->state.player->movement.y = -1.0f;
-        current_scene->state.player->animation_indices = current_scene->state.player->walking[current_scene->state.player->DOWN];
-    }
+}
 
-    if (glm::length(current_scene->state.player->movement) > 1.0f)
-    {
-        current_scene->state.player->movement = glm::normalize(current_scene->state.player->movement);
+// Fixed steps are driven only by their input, so a recording replays the same no matter how
+// steps were grouped into frames
+void step()
+{
+    InputFrame input;
+    if (!input_stream->next(input)) {
+        // The replay has run out
+        game_is_running = false;
+        return;
     }
+    
+    game->step(input);
 }
 
-void update()
+// The simulation thread: steps at the fixed rate on its own clock and publishes a snapshot whenever it has stepped
+void simulate()
 {
-    float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
-    float delta_time = ticks - previous_ticks;
-    previous_ticks = ticks;
+    PROFILE_THREAD("simulation");
     
-    delta_time += accumulator;
+    FramePacer pacer;
+    Uint64 step_ticks = pacer.seconds_to_ticks(FIXED_TIMESTEP);
+    Uint64 next_step = SDL_GetPerformanceCounter() + step_ticks;
     
-    if (delta_time < FIXED_TIMESTEP)
-    {
-        accumulator = delta_time;
-        return;
-    }
+    // Input events are stamped by SDL_GetTicks; this lines its clock up with the one steps are due by
+    Uint64 clock_origin = SDL_GetPerformanceCounter();
+    Uint32 ticks_origin = SDL_GetTicks();
     
-    while (delta_time >= FIXED_TIMESTEP) {
-        current_scene->update(FIXED_TIMESTEP);
-        effects->update(FIXED_TIMESTEP);
-        
-        is_colliding_bottom = current_scene->state.player->collided_bottom;
+    while (game_is_running)
+    {
+        // Asleep until the next step is due, rather than spinning on the clock
+        pacer.wait_until(next_step);
         
-        delta_time -= FIXED_TIMESTEP;
-    }
-    
-    accumulator = delta_time;
-    
-    // Prevent the camera from showing anything outside of the "edge" of the level
-    view_matrix = glm::mat4(1.0f);
-   
-        if (current_scene->state.player->get_position().x > LEVEL1_LEFT_EDGE
-            && (current_scene != encounterA && current_scene != encounterB)) {
-            float yCamera = 3.75f;
-
-            if (current_scene->state.player->get_position().y > -2.0f && current_scene->state.player->get_position().x > 13.0f) {
-                // yCamera = -current_scene->state.player->get_position().y;
+        {
+            PROFILE_ZONE("update");
+            
+            // Catch up on every step that fell due, however long the wait overshot
+            Uint64 now = SDL_GetPerformanceCounter();
+            while (now >= next_step && game_is_running) {
+                live_input.set_step_time(ticks_origin + (Uint32) ((next_step - clock_origin) * 1000 / SDL_GetPerformanceFrequency()));
+                step();
+                next_step += step_ticks;
             }
-
-            view_matrix = glm::translate(view_matrix, glm::vec3(-current_scene->state.player->get_position().x, yCamera, 0));
-        }
-        else {
-            view_matrix = glm::translate(view_matrix, glm::vec3(-5, 3.75, 0));
         }
-
-        if (current_scene->state.player->get_position().y < -10.0f) {
-            //current_scene->state.player->set_position(glm::vec3(2.0f, 1.0f, 0.0f));
+        
+        RenderSnapshot &snapshot = snapshots->write_buffer();
+        game->snapshot(&snapshot);
+        
+        // Keep whichever input is older; SDL's ticks wrap, so compare by difference
+        uint32_t taken = live_input.take_first_taken();
+        uint32_t unreported = unreported_input_timestamp.load();
+        while (taken != 0 && (unreported == 0 || (int32_t) (taken - unreported) < 0)) {
+            if (unreported_input_timestamp.compare_exchange_weak(unreported, taken)) break;
         }
+        snapshot.input_timestamp = unreported_input_timestamp.load();
+        snapshots->publish();
+        
+        if (memory_report_requested.exchange(false)) game->report_memory();
+    }
     
-    view_matrix = glm::translate(view_matrix, effects->view_offset);
+    simulation_finished = true;
 }
 
-void render()
+// Returns false when there was nothing new to show and the frame was skipped
+bool render(float delta_time)
 {
-    program.SetViewMatrix(view_matrix);
+    PROFILE_ZONE("render");
+    
+    snapshots->acquire();
+    
+    const RenderSnapshot &snapshot = snapshots->read_buffer();
+    
+    if (snapshot.scene_id != rendered_scene_id) {
+        rendered_scene_id = snapshot.scene_id;
+        ALLOC_WARM_UP();
+    }
+    
+    // After acquiring, so any texture the snapshot's scene asked for is uploaded before it's drawn
+    resources->service();
+    hud->update(delta_time, snapshot.counters);
+    
+    // Effects are purely visual, so they run at the display rate rather than the simulation's
+    effects->update(delta_time);
+    
+    // A static scene already on screen stays there unless something drawn over it is moving
+    bool unchanged = snapshot.is_static && snapshot.scene_id == shown_static_scene_id;
+    if (unchanged && !redraw_requested && !effects->is_active() && !hud->visible) {
+        // Input a static scene took without changing has no frame to show it, so it has no latency either;
+        // left pending, it would be charged for the wait until something else redraws
+        uint32_t ignored = snapshot.input_timestamp;
+        if (ignored != 0) unreported_input_timestamp.compare_exchange_strong(ignored, 0);
+        return false;
+    }
+    
+    shown_static_scene_id = snapshot.is_static ? snapshot.scene_id : -1;
+    redraw_requested = false;
+    view_matrix = glm::translate(snapshot.view_matrix, effects->view_offset);
+    
+    program->SetViewMatrix(view_matrix);
     glClear(GL_COLOR_BUFFER_BIT);
- 
-    glUseProgram(program.programID);
-    current_scene->render(&program);
+    
+    render_lighting->clear_dynamic_lights();
+    for (size_t i = 0; i < snapshot.lights.size(); i++) render_lighting->add_dynamic_light(snapshot.lights[i]);
+    render_lighting->cull(view_matrix, projection_matrix);
+    render_lighting->upload_visible(program);
+    
+    snapshot.draw(program, render_lighting, resources, &text_vertices);
     effects->render();
+    hud->render();
+    
+    {
+        PROFILE_ZONE("swap");
+        SDL_GL_SwapWindow(display_window);
+    }
+    
+    // Only the first swap showing an input reports it: redrawing the same snapshot, or an older one stamped
+    // with it, finds it already cleared
+    uint32_t shown = snapshot.input_timestamp;
+    if (shown != 0 && unreported_input_timestamp.compare_exchange_strong(shown, 0)) {
+        Uint32 latency = SDL_GetTicks() - snapshot.input_timestamp;
+        input_latency.add(latency);
+        
+#ifdef PROFILER_ENABLED
+        // Also as a zone, so the trace shows which frames each input waited through
+        uint64_t now = Profiler::now();
+        uint64_t waited = (uint64_t) latency * 1000000;
+        Profiler::record("input to photon", now > waited ? now - waited : 0, now);
+#endif
+    }
+    
+    return true;
+}
 
-    if (current_scene != menu) {
-        program.SetLightPosition(current_scene->state.player->get_position());
+// Steps copies of the replay until every one has run out, one job per copy. Copy i is seeded with
+// seed + i: copy 0 reproduces the recording exactly, the rest play the same inputs against different dice.
+void run_headless()
+{
+    NullResources null_resources;
+    
+    std::vector<Game*> games;
+    std::vector<InputStream*> inputs;
+    for (int i = 0; i < headless_copies; i++) {
+        games.push_back(new Game(&null_resources, jobs, seed + i));
+        inputs.push_back(new InputReplay(replay_path));
     }
-    else {
-        program.SetLightPosition(glm::vec3(3.5f, 3.5f, 0.0f));
+    
+    // Replay as fast as possible: no window, no rendering, no waiting for the clock
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    jobs->parallel_for(headless_copies, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            InputFrame input;
+            while (inputs[i]->next(input)) games[i]->step(input);
+        }
+    });
+    
+    Uint64 end = SDL_GetPerformanceCounter();
+    
+    LOG("replayed " << headless_copies << " copies on " << jobs->get_thread_count() << " threads in "
+        << (double) (end - start) * MILLISECONDS_IN_SECOND / SDL_GetPerformanceFrequency() << " ms");
+    
+    for (int i = 0; i < headless_copies; i++) {
+        if (headless_copies > 1) LOG("copy " << i);
+        games[i]->report();
+        games[i]->report_memory();
+        
+        delete games[i];
+        delete inputs[i];
     }
     
-    SDL_GL_SwapWindow(display_window);
+#ifdef ALLOC_TRACKING_ENABLED
+    Allocations::report();
+#endif
 }
 
 void shutdown()
 {    
-    SDL_Quit();
+    if (input_stream != &live_input) delete input_stream;
     
-    delete world;
-    delete encounterA;
-    delete encounterB;
+    delete game;
     delete effects;
+    delete hud;
+    delete snapshots;
+    delete render_lighting;
+    delete resources;
+    delete jobs;
+    ShaderProgram::CleanupAll();
+    
+    SDL_Quit();
 }
 
 int main(int argc, char* argv[])
 {
+    parse_arguments(argc, argv);
+    
+    if (level_source_path != nullptr)
+    {
+        bool built = Level::build(level_source_path, level_output_path);
+        
+        if (input_stream != &live_input) delete input_stream;
+        delete jobs;
+        return built ? 0 : 1;
+    }
+    
+    if (headless)
+    {
+        PROFILE_THREAD("main");
+        run_headless();
+        
+        if (input_stream != &live_input) delete input_stream;
+        delete jobs;
+        return 0;
+    }
+    
     initialise();
     
+    previous_frame_counter = SDL_GetPerformanceCounter();
+    simulation = std::thread(simulate);
+    
     while (game_is_running)
     {
-        process_input();
-        update();
+        // Whole-frame time and counters, as shown by the HUD during this render
+        Uint64 frame_counter = SDL_GetPerformanceCounter();
+        float delta_time = (float) (frame_counter - previous_frame_counter) / SDL_GetPerformanceFrequency();
+        previous_frame_counter = frame_counter;
+        Counters::end_frame();
+        ALLOC_FRAME_END();
         
-        if (current_scene->state.next_scene_id >= 0) {
-            auto prev = current_scene;
-            switch_to_scene(levels[current_scene->state.next_scene_id]);
-            current_scene->state.player->lives = prev->state.player->lives;
-        }
+        process_input();
+        bool drawn = render(delta_time);
         
-        render();
+        // Vsync already held a drawn frame back in the swap; anything else waits out the rest of the frame here
+        if (!drawn || !vsync) render_pacer.wait_until(frame_counter + render_pacer.seconds_to_ticks(RENDER_INTERVAL));
+    }
+    
+    // The simulation may be halfway through a scene change that's waiting on a texture upload
+    while (!simulation_finished) {
+        resources->service();
+        SDL_Delay(SHUTDOWN_POLL_MS);
     }
+    simulation.join();
+    
+    if (replay_path != nullptr) game->report();
     
     shutdown();
     return 0;
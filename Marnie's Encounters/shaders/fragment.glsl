@@ -1,5 +1,7 @@
+R"GLSL(
 uniform vec4 color;
 
 void main() {
     gl_FragColor = color;
 }
+)GLSL"
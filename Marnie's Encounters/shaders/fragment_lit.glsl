@@ -1,8 +1,20 @@
+R"GLSL(
+// MAX_LIGHTS is defined ahead of this, from Lighting.h; see main.cpp
+
 uniform sampler2D diffuse;
-uniform vec2 lightPosition;
+uniform sampler2D palette;
+uniform bool paletted;
+uniform sampler2D lightmap;
+uniform vec2 lightmapOrigin;
+uniform vec2 lightmapSize;
+uniform int lightCount;
+uniform vec2 lightPositions[MAX_LIGHTS];
+uniform float lightRadii[MAX_LIGHTS];
+uniform float lightIntensities[MAX_LIGHTS];
 
 varying vec2 texCoordVar;
 varying vec2 varPosition;
+varying vec4 tileCellVar;
 
 float attenuate(float dist, float a, float b)
 {
@@ -11,7 +23,30 @@ float attenuate(float dist, float a, float b)
 
 void main()
 {
-     float brightness = attenuate(distance(lightPosition, varPosition), 1.0, 0.0);
-     vec4 color = texture2D(diffuse, texCoordVar);
-     gl_FragColor = vec4(color.rgb * brightness, color.a);
+     // Static lights were baked when the level loaded
+     float brightness = texture2D(lightmap, (varPosition - lightmapOrigin) / lightmapSize).r;
+     
+     // Only the dynamic lights the CPU picked for this draw are looked at
+     for (int i = 0; i < MAX_LIGHTS; i++)
+     {
+          if (i >= lightCount) break;
+          
+          float dist = distance(lightPositions[i], varPosition);
+          
+          // Fade out over the last quarter of the radius so culled lights don't pop
+          float falloff = 1.0 - smoothstep(lightRadii[i] * 0.75, lightRadii[i], dist);
+          brightness += lightIntensities[i] * attenuate(dist, 1.0, 0.0) * falloff;
+     }
+     
+     // Map quads cover several tiles and carry their tileset cell (origin, size); anything else
+     // leaves the attribute disabled, which reads as z = 0, and samples its UVs as they are
+     vec2 uv = texCoordVar;
+     if (tileCellVar.z > 0.0) uv = tileCellVar.xy + fract(texCoordVar) * tileCellVar.zw;
+     
+     vec4 color = texture2D(diffuse, uv);
+     
+     // Paletted textures hold an index out of 255 in red; entry i sits in the middle of texel i
+     if (paletted) color = texture2D(palette, vec2(color.r * (255.0 / 256.0) + (0.5 / 256.0), 0.5));
+     gl_FragColor = vec4(color.rgb * min(brightness, 1.0), color.a);
 }
+)GLSL"
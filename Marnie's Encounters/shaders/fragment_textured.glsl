@@ -1,7 +1,15 @@
+R"GLSL(
 
 uniform sampler2D diffuse;
+uniform sampler2D palette;
+uniform bool paletted;
 varying vec2 texCoordVar;
 
 void main() {
-    gl_FragColor = texture2D(diffuse, texCoordVar);
+    vec4 color = texture2D(diffuse, texCoordVar);
+    
+    // Same lookup as fragment_lit.glsl
+    if (paletted) color = texture2D(palette, vec2(color.r * (255.0 / 256.0) + (0.5 / 256.0), 0.5));
+    gl_FragColor = color;
 }
+)GLSL"
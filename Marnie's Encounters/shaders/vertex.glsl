@@ -1,3 +1,4 @@
+R"GLSL(
 attribute vec4 position;
 
 uniform mat4 modelMatrix;
@@ -9,3 +10,4 @@ void main()
 	vec4 p = viewMatrix * modelMatrix  * position;
 	gl_Position = projectionMatrix * p;
 }
+)GLSL"
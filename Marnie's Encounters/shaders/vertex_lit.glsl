@@ -1,5 +1,7 @@
+R"GLSL(
 attribute vec4 position;
 attribute vec2 texCoord;
+attribute vec4 tileCell;
 
 uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
@@ -7,11 +9,14 @@ uniform mat4 projectionMatrix;
 
 varying vec2 texCoordVar;
 varying vec2 varPosition;
+varying vec4 tileCellVar;
 
 void main()
 {
     vec4 p = modelMatrix * position;
     varPosition = vec2(p.x, p.y);
     texCoordVar = texCoord;
+    tileCellVar = tileCell;
     gl_Position = projectionMatrix * viewMatrix * p;
 }
+)GLSL"
@@ -1,3 +1,4 @@
+R"GLSL(
 attribute vec4 position;
 attribute vec2 texCoord;
 
@@ -12,4 +13,4 @@ void main()
 	vec4 p = viewMatrix * modelMatrix  * position;
     texCoordVar = texCoord;
 	gl_Position = projectionMatrix * p;
-}
\ No newline at end of file
+})GLSL"